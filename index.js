@@ -13,6 +13,7 @@
 
 const fuerte = require('bindings')('arango-node-driver');
 const { URL } = require('url');
+const { Readable } = require('stream');
 
 // ------------------------------------
 // connect
@@ -22,9 +23,19 @@ const { URL } = require('url');
  * Open a connection to a database server.
  * @function connect
  * @param {Object} options - options for the connection or a host string.
- * @param {string} options.host - URL of the server. E.g. "http://localhost:8529"
+ * @param {string} options.host - URL of the server. E.g. "http://localhost:8529" or "unix:///tmp/arangodb.sock"
+ * (unix domain sockets only work if your fuerte build supports them, see `ConnectionBuilder.host`).
+ * @param {string[]} options.hosts - Optional, URLs of several coordinators. Requests are routed between them
+ * (see `ConnectionBuilder.hosts`). Replaces `options.host`.
  * @param {string} options.user - Optional username for authentication.
  * @param {string} options.pass - Optional password for authentication.
+ * @param {boolean} options.resolveCollectionNames - Optional, decode custom `_id` values with collection names.
+ * @param {boolean} options.retainRequest - Optional, set to false so responses do not keep their request alive.
+ * @param {Number} options.poolSize - Optional, maximum number of connections to the server (defaults to 1).
+ * @param {Number} options.spillThreshold - Optional, payload size (in bytes) above which responses are moved to a temp file
+ * once received. This shortens how long large payloads stay in memory, it does not limit peak memory use.
+ * @param {Number} options.hedgePercentile - Optional, hedge idempotent requests after this percentile of recent latency
+ * (see `ConnectionBuilder.hedgePercentile`).
  * @return {Connection}
  * @example
  * const conn = fuerte.connect("http://localhost:8529");
@@ -35,7 +46,9 @@ fuerte.connect = function(options) {
         options = { host: options };
     }
     var builder = new fuerte.ConnectionBuilder();
-    if (options.host) {
+    if (options.hosts && options.hosts.length > 0) {
+        builder.hosts = options.hosts;
+    } else if (options.host) {
         builder.host = options.host;
     } else {
         throw new Error("host option missing");
@@ -46,9 +59,109 @@ fuerte.connect = function(options) {
     if (options.pass) {
         builder.password = options.pass;
     }
+    if (options.resolveCollectionNames) {
+        builder.resolveCollectionNames = true;
+    }
+    if (options.retainRequest === false) {
+        builder.retainRequest = false;
+    }
+    if (options.spillThreshold) {
+        builder.spillThreshold = options.spillThreshold;
+    }
+    if (options.poolSize) {
+        builder.poolSize = options.poolSize;
+    }
+    if (options.hedgePercentile) {
+        builder.hedgePercentile = options.hedgePercentile;
+    }
     return builder.connect();
 }
 
+/**
+ * Enable or disable translation of the system attributes (_key, _rev, _id, _from & _to)
+ * when encoding velocypack.
+ * With translation enabled, these attribute names are encoded as 1-byte integer keys
+ * (the same translation the ArangoDB server uses internally), which makes documents smaller.
+ * Translated keys are always understood when decoding (including projections and rendering as JSON).
+ * Builders keep the setting that was active when they were created.
+ * @function vpackTranslateAttributes
+ * @param {boolean} enable - Enable or disable the translation.
+ * @return {boolean} - True if translation was enabled before this call.
+ * @example
+ * fuerte.vpackTranslateAttributes(true);
+ */
+
+/**
+ * Encode a list of values into velocypack in a single call.
+ * The slices are stored back to back in one Buffer.
+ * @function vpackEncodeMany
+ * @param {Array} values - Values to encode.
+ * @return {Object} - `buffer` containing all slices and `offsets`, a Uint32Array where
+ * slice i starts at `offsets[i]` and ends at `offsets[i+1]`.
+ * @example
+ * const { buffer, offsets } = fuerte.vpackEncodeMany(docs);
+ * const second = buffer.slice(offsets[1], offsets[2]);
+ */
+
+/**
+ * Decode a list of velocypack slices in a single call.
+ * @function vpackDecodeMany
+ * @param {Buffer[]|Buffer} slices - Array of Buffers (one slice each), or one Buffer with concatenated slices.
+ * @param {Object} [options] - Optional `paths` projection, as in `vpackDecode`.
+ * @return {Array} - The decoded values.
+ * @example
+ * const docs = fuerte.vpackDecodeMany(fuerte.vpackEncodeMany(input).buffer);
+ */
+
+/**
+ * Return statistics of the pool of velocypack buffers that is used to encode
+ * values (vpackEncode, Request.addBody).
+ * The retained buffers of a pool that was not used for 5 seconds are halved (every 5 seconds).
+ * @function vpackPoolStats
+ * @return {Object} - Object with `hits` & `misses` (acquired buffers that did/did not come from the pool),
+ * `retainedBytes` & `retainedBuffers` (memory currently kept for reuse).
+ */
+
+/**
+ * Cache the velocypack encoding of a frozen object or array.
+ * Whenever the same object is encoded again (also as part of another value),
+ * the cached bytes are used instead of walking the object.
+ * The object must be deeply frozen, use {@link freeze} for that.
+ * @function vpackMemoize
+ * @param {Object|Array} value - Frozen value to cache the encoding of.
+ * @return {Object|Array} - The value itself.
+ */
+
+/**
+ * Drop the cached velocypack encoding of an object.
+ * Cached encodings are also dropped when their object is garbage collected.
+ * @function vpackForget
+ * @param {Object|Array} value - Value passed to `vpackMemoize` before.
+ * @return {boolean} - True if an encoding was cached.
+ */
+
+/**
+ * Deeply freeze an object or array and cache its velocypack encoding.
+ * Use it for constant values that are sent often, such as bind variables or filter specifications.
+ * @function freeze
+ * @param {Object|Array} value - Value to freeze.
+ * @return {Object|Array} - The (now frozen) value itself.
+ * @example
+ * const bindVars = fuerte.freeze({ status: "active", limit: 100 });
+ * conn.post('/_api/cursor', { query: QUERY, bindVars: bindVars });
+ */
+fuerte.freeze = function(value) {
+    const deepFreeze = function(v) {
+        if (v === null || typeof v != 'object' || Object.isFrozen(v)) {
+            return;
+        }
+        Object.freeze(v);
+        Object.getOwnPropertyNames(v).forEach((name) => deepFreeze(v[name]));
+    };
+    deepFreeze(value);
+    return fuerte.vpackMemoize(value);
+}
+
 // ------------------------------------
 // Connection
 // ------------------------------------
@@ -56,9 +169,42 @@ fuerte.connect = function(options) {
 /**
  * ConnectionBuilder helper class to build connections.
  * @class ConnectionBuilder
- * @property {string} host - URL of the host. E.g. "http://localhost:8529"
+ * @property {string} host - URL of the host. E.g. "http://localhost:8529".
+ * Unix domain socket URLs such as "unix:///path/to/arangodb.sock" (HTTP), "http+unix:///path/to/arangodb.sock"
+ * or "vst+unix:///path/to/arangodb.sock" keep their socket path (an absolute path is taken as "unix://" + path)
+ * and are passed to fuerte unchanged. They only work if your fuerte build supports unix domain sockets;
+ * this binding does not implement the transport itself.
+ * @property {string[]} hosts - URLs of several hosts (coordinators), used instead of `host`.
+ * Each request goes to the host with the lowest (average latency x unfinished requests).
+ * A host is taken out of rotation after 3 requests in a row fail with a connection, read or write
+ * error (or a 503 response); timeouts do not count. It is then probed with `GET /_api/version`
+ * (after 0.5s, doubling up to 30s) until it answers again. Probes are started when requests are sent,
+ * there is no background timer. A request that failed because its host could not be connected to is
+ * retried once on another host.
+ * `poolSize` applies per host.
  * @property {string} userName - Name used for authentication of a new connection.
  * @property {string} password - Password used for authentication of a new connection.
+ * @property {boolean} resolveCollectionNames - If set, custom velocypack `_id` values are decoded
+ * as "collection-name/key" instead of "collection-id/key". Collection names are loaded
+ * from `/_api/collection` (per connection) whenever a response contains an unknown collection id.
+ * @property {boolean} retainRequest - If set (the default), each response references its request
+ * (`Response.request`). Clear it to let requests (and their bodies) be garbage collected early.
+ * @property {Number} poolSize - Maximum number of connections to the server that a connection uses (defaults to 1).
+ * Requests go to the connection with the fewest unfinished requests. Connections are opened when all
+ * existing ones are busy and closed after 30 seconds without requests.
+ * @property {Number} spillThreshold - Payload size (in bytes) above which a response is moved out of memory
+ * into an unlinked, memory mapped temp file (in TMPDIR), written on the libuv threadpool before the callback runs.
+ * fuerte receives the whole payload into memory first, so this is not a memory cap: it only shortens how long
+ * a large payload stays resident (e.g. while the response object is kept around).
+ * The payload, slices and body accessors read from that file; such responses are not parsed or rendered on the
+ * IO thread (`parseJson`, `renderJson`). 0 (the default) keeps all responses in memory.
+ * @property {Number} hedgePercentile - Percentile (e.g. 95) of recent response times after which an unfinished
+ * GET request (or a request marked `idempotent`) is sent a second time, on another connection or host.
+ * Response times are kept per route (method and first two path segments, e.g. `GET /_api/document`), a route
+ * is hedged once it has 16 samples. The first successful response is used (and sampled), the other one is
+ * dropped without creating a Response; a failure is only reported if both copies fail.
+ * The copy never goes to the connection of the first request. It is skipped when there is no other connection,
+ * so combine this with `poolSize` > 1 or several `hosts`. 0 (the default) disables hedging.
  */
 const ConnectionBuilder = fuerte.ConnectionBuilder;
 
@@ -74,27 +220,41 @@ const ConnectionBuilder = fuerte.ConnectionBuilder;
  * const connection = builder.connect();
  */
 ConnectionBuilder.prototype.connect = function() {
-    let host = this.host;
-    if (host) {
-        // Extract username+password from host (if set)
-        try {
-            const u = new URL(host);
-            // Save username+password
-            if (u.username && !this.userName) this.userName = u.username;
-            if (u.password && !this.password) this.password = u.password;
-            u.username = undefined;
-            u.password = undefined;
-            // Save normalized url
-            let x = `${u.protocol}//${u.host}`;
-            this.host = x;
-        } catch (err) {
-            // Ignore
-        }
+    if (this.host) {
+        this.host = this.normalizeHost(this.host);
+    }
+    if (this.hosts && this.hosts.length > 0) {
+        this.hosts = this.hosts.map((host) => this.normalizeHost(host));
+        this.host = this.host || this.hosts[0];
+        this.nativeHosts = this.hosts;
     }
     this.nativeHost = this.host || 'localhost';
     return this.nativeConnect();
 };
 
+// Extract username+password from a host URL (if set) and return the normalized URL.
+ConnectionBuilder.prototype.normalizeHost = function(host) {
+    if (host.startsWith('/')) {
+        // path of a unix domain socket
+        return `unix://${host}`;
+    }
+    try {
+        const u = new URL(host);
+        if (u.protocol.endsWith('unix:')) {
+            // the path is the socket
+            return `${u.protocol}//${u.pathname}`;
+        }
+        // Save username+password
+        if (u.username && !this.userName) this.userName = u.username;
+        if (u.password && !this.password) this.password = u.password;
+        // Return normalized url
+        return `${u.protocol}//${u.host}`;
+    } catch (err) {
+        // Ignore
+        return host;
+    }
+};
+
 
 /**
  * Request data send to a database server.
@@ -104,16 +264,22 @@ ConnectionBuilder.prototype.connect = function() {
  * @property {string} method - (HTTP) method of this request.
  * @property {string} contentType - Content-Type of this request.
  * @property {string} acceptType - Accept-Type of this request.
+ * @property {boolean} renderJson - If set, a velocypack response is rendered as JSON text on the IO thread
+ * (see {@link Response#jsonBuffer}).
+ * @property {boolean} parseJson - If set, a JSON response is parsed into velocypack on the IO thread, so reading
+ * `Response.body` only has to decode it. Otherwise the JSON is parsed on first access of `body`.
+ * @property {boolean} idempotent - If set, the request may be hedged (see `ConnectionBuilder.hedgePercentile`)
+ * even though it is not a GET. Use it for read-only queries.
  */
 const Request = fuerte.Request;
 
 /**
- * Add an object|array|value or Buffer containing a velocypack slice to this request.
+ * Add an object|array|value, a {@link Builder} or Buffer containing a velocypack slice to this request.
  * Non-Buffer argument is converted to velocypack automatically.
  * @function addBody
  * @memberof Request
  * @instance
- * @param {any|Buffer} data - Body to add
+ * @param {any|Builder|Buffer} data - Body to add
  * @return {Request} - The request itself.
  * @example
  * const req = new fuerte.Request();
@@ -129,6 +295,41 @@ const Request = fuerte.Request;
  * @return {Request} - The request itself.
  */
 
+/**
+ * Add a JSON text to this request.
+ * The text is not parsed on the JS thread. It is converted to velocypack on a
+ * worker thread when the request is sent. Invalid JSON fails the request.
+ * @function addJsonBody
+ * @memberof Request
+ * @instance
+ * @param {string|Buffer} json - JSON text to add
+ * @return {Request} - The request itself.
+ * @example
+ * const req = new fuerte.Request();
+ * req.addJsonBody('{"name":"Jan"}');
+ */
+
+/**
+ * Add (a range of) a file as binary payload to this request.
+ * The file is not read on the JS thread, nor into the JS heap. It is read on a worker thread
+ * when the request is sent. The body is still buffered in full (outside the JS heap) before
+ * it is sent, so bodies larger than 1GiB are rejected. A file that cannot be read fails the request.
+ * @function addFile
+ * @memberof Request
+ * @instance
+ * @param {string|Number} file - Path or descriptor of the file.
+ * @param {Number} [offset] - Offset of the first byte to send (defaults to 0).
+ * @param {Number} [length] - Number of bytes to send (defaults to the rest of the file).
+ * @return {Request} - The request itself.
+ * @example
+ * const req = new fuerte.Request();
+ * req.method = 'post';
+ * req.path = '/_api/import';
+ * req.addQueryParameter('collection', 'users');
+ * req.addQueryParameter('type', 'documents');
+ * req.addFile('/data/users.jsonl');
+ */
+
 /**
  * Add a Buffer containing binary data to this request.
  * The contents of the buffer is not inspected.
@@ -167,6 +368,62 @@ const Request = fuerte.Request;
  * req.addHeader("X-CustomHeader", "123");
  */
 
+/**
+ * Builder for velocypack values, to create (large) request bodies incrementally
+ * without building the entire value in JS first.
+ * Once all arrays & objects are closed, the builder can be passed to {@link Request#addBody}.
+ * @class Builder
+ * @property {boolean} isClosed - True if all arrays & objects have been closed.
+ * @property {number} byteSize - Size of the built value (undefined while not closed).
+ * @example
+ * const builder = new fuerte.Builder();
+ * builder.openArray();
+ * for (const doc of docs()) {
+ *   builder.addValue(doc);
+ * }
+ * builder.close();
+ * req.addBody(builder);
+ */
+const Builder = fuerte.Builder;
+
+/**
+ * Open an array, or an object. Inside an open object the attribute name must be given.
+ * @function openArray
+ * @memberof Builder
+ * @instance
+ * @param {string} [key] - Attribute name (when inside an object)
+ * @return {Builder} - The builder itself.
+ */
+
+/**
+ * Add a value, converted to velocypack, as member of the open object.
+ * Use {@link Builder#addValue} inside an array (or for a top level value).
+ * @function add
+ * @memberof Builder
+ * @instance
+ * @param {string} key - Attribute name
+ * @param {*} value - Value to add
+ * @return {Builder} - The builder itself.
+ */
+
+/**
+ * Add a value, converted to velocypack, to the open array (or as the top level value).
+ * Use {@link Builder#add} inside an object.
+ * @function addValue
+ * @memberof Builder
+ * @instance
+ * @param {*} value - Value to add
+ * @return {Builder} - The builder itself.
+ */
+
+/**
+ * Close the innermost open array or object.
+ * @function close
+ * @memberof Builder
+ * @instance
+ * @return {Builder} - The builder itself.
+ */
+
 /**
  * Response data resulting from a request to a database server.
  * @class Response
@@ -179,14 +436,144 @@ const Request = fuerte.Request;
  * If the payload is empty, undefined is returned.
  * @property {Buffer} payload - Entire (raw) payload of the response in a buffer.
  * If the payload is empty, an empty buffer is returned.
+ * The buffer is not a copy, it views the response data (which is kept until the buffer is garbage collected).
  * @property {[]Buffer} slices - Array of buffers, containing the slices of the response.
- * Each slice is contained in a single buffer.
+ * Each slice is contained in a single buffer, which views the response data like `payload`.
  * If the response does not have a velocypack content type, undefined
  * is returned.
  * @property {Request} request - Request that resulted in this response.
+ * Undefined if the connection was opened with `retainRequest` set to false.
  */
 const Response = fuerte.Response;
 
+/**
+ * Decode the payload of this response, materializing only the given attribute paths.
+ * Arrays (e.g. query results) are projected element wise.
+ * Attributes that do not exist are omitted from the result.
+ * @function project
+ * @memberof Response
+ * @instance
+ * @param {string[]|Projection} paths - Attribute paths (e.g. "a.b") or a compiled {@link Projection}.
+ * @return {*} - The projected object/array/value.
+ * @example
+ * const res = await conn.post('/_api/cursor', { query: 'FOR d IN docs RETURN d' });
+ * const rows = res.project(['result._key', 'result.a.b']);
+ */
+
+/**
+ * Decode the payload of this response column wise.
+ * The payload must be an array of objects, or an object (e.g. a cursor result)
+ * with such an array in its `result` attribute.
+ * Numeric columns are filled into typed arrays, without creating an object per row.
+ * Missing values are stored as NaN (float64), 0 (int32, uint32), null (string) or undefined (any).
+ * The same decoding is available for Buffers as `fuerte.vpackDecodeColumns(buffer, columns)`.
+ * @function columns
+ * @memberof Response
+ * @instance
+ * @param {Object} columns - Maps attribute names to a column type: "float64", "int32", "uint32", "string" or "any".
+ * @return {Object} - Object with one Float64Array/Int32Array/Uint32Array/Array per column.
+ * @example
+ * const res = await conn.post('/_api/cursor', { query: 'FOR m IN measurements RETURN m' });
+ * const { ts, value } = res.columns({ ts: 'float64', value: 'float64', sensor: 'string' });
+ */
+
+/**
+ * Free the native data of this response now, instead of when the response is garbage collected.
+ * The size of that data is reported to the JS engine, so it is taken into account when scheduling
+ * garbage collections; `release` returns it deterministically.
+ * Afterwards only values that were read before (e.g. `body`) remain available.
+ * @function release
+ * @memberof Response
+ * @instance
+ * @example
+ * const res = await conn.get('/_api/document/users/jan');
+ * const doc = res.body;
+ * res.release();
+ */
+
+/**
+ * Return the value of a single header of this response, without building the `header` object.
+ * The name is matched case-insensitively.
+ * @function getHeader
+ * @memberof Response
+ * @instance
+ * @param {string} name - Name of the header.
+ * @return {string} - The header value, undefined if the response has no such header.
+ * @example
+ * const etag = res.getHeader('etag');
+ */
+
+/**
+ * Return the body of this response as JSON text in a Buffer, without decoding it into JS values.
+ * Velocypack bodies are rendered on the IO thread when the request had `renderJson` set,
+ * otherwise they are rendered when this function is called. Multiple slices are rendered as an array.
+ * @function jsonBuffer
+ * @memberof Response
+ * @instance
+ * @return {Buffer} - JSON text, undefined if the response has no body.
+ * @example
+ * const res = await conn.get({ path: '/_api/document/users/jan', renderJson: true });
+ * httpResponse.end(res.jsonBuffer());
+ */
+
+/**
+ * Compiled set of attribute paths, to be reused across calls to
+ * {@link Response#project} and `vpackDecode(buffer, {paths})`.
+ * @class Projection
+ * @param {string[]} paths - Attribute paths, e.g. ["_key", "a.b", "c"]
+ * @example
+ * const keys = new fuerte.Projection(["_key", "a.b"]);
+ * const value = fuerte.vpackDecode(buffer, { paths: keys });
+ */
+const Projection = fuerte.Projection;
+
+/**
+ * Read-only random access to a file of concatenated velocypack slices.
+ * The file is memory mapped and not read into memory up front. An index of slice offsets
+ * is built lazily, up to the slice that is accessed; reading `length` indexes the entire file.
+ * A file that ends with a partial slice throws when that slice is reached.
+ * @class VPackFile
+ * @param {string} path - Path of the file.
+ * @property {Number} length - Number of slices in the file.
+ * @property {Number} byteSize - Size of the file.
+ * @example
+ * const file = new fuerte.VPackFile("fixtures.vpack");
+ * for (let i = 0; i < file.length; i++) {
+ *   conn.post('/_api/document/users', file.slice(i));
+ * }
+ */
+const VPackFile = fuerte.VPackFile;
+
+/**
+ * Return a slice of the file in a Buffer.
+ * The Buffer references the mapped file, nothing is copied. Writing to it does not change the file.
+ * @function slice
+ * @memberof VPackFile
+ * @instance
+ * @param {Number} index - Index of the slice.
+ * @return {Buffer} - The slice.
+ */
+
+/**
+ * Decode a slice of the file.
+ * @function decode
+ * @memberof VPackFile
+ * @instance
+ * @param {Number} index - Index of the slice.
+ * @param {Object} [options] - Optional `paths` projection, as in `vpackDecode`.
+ * @return {any} - The decoded value.
+ */
+
+/**
+ * Add a slice of the file as body to a request, without creating a Buffer for it.
+ * @function addToRequest
+ * @memberof VPackFile
+ * @instance
+ * @param {Request} request - Request to add the slice to.
+ * @param {Number} index - Index of the slice.
+ * @return {Request} - The request.
+ */
+
 /**
  * Create a fuerte Request from given arguments.
  * @function
@@ -213,6 +600,15 @@ function createRequestFromOptions(options, data, method) {
     if (options.acceptType) {
         req.acceptType = options.acceptType;
     }
+    if (options.renderJson) {
+        req.renderJson = true;
+    }
+    if (options.idempotent) {
+        req.idempotent = true;
+    }
+    if (options.parseJson) {
+        req.parseJson = true;
+    }
     if (typeof options.query == 'object') {
         const query = options.query;
         for (var property in query) {
@@ -233,6 +629,12 @@ function createRequestFromOptions(options, data, method) {
     if (data) {
         req.addBody(data);
     }
+    if (options.json) {
+        req.addJsonBody(options.json);
+    }
+    if (options.file !== undefined) {
+        req.addFile(options.file);
+    }
     return req;
 }
 
@@ -240,6 +642,8 @@ function createRequestFromOptions(options, data, method) {
  * Connection to a database server.
  * @class Connection
  * @property {Number} requestsLeft - Number of requests that have not yet finished.
+ * @property {Number} poolSize - Number of currently open connections to the server(s).
+ * @property {Number} healthyEndpoints - Number of hosts that are currently not taken out of rotation.
  */
 const Connection = fuerte.Connection;
 
@@ -409,6 +813,94 @@ Connection.prototype.sendRequest = function(req, cb) {
     }));
 };
 
+/**
+ * Run an AQL query and stream its result.
+ * The result is fetched one batch at a time through a cursor. The next batch is only requested
+ * when the stream is read from, so at most a few batches are kept in memory, no matter how large
+ * the result is. Destroying the stream early deletes the cursor on the server.
+ * Each chunk of the (object mode) stream is an array with the documents of one batch.
+ * @function
+ * @param {QueryStreamOptions|string} options - Options or the query string.
+ * @returns {Readable} - Stream of result batches.
+ * @example
+ * const conn = connect("vst://localhost:8529");
+ * conn.queryStream({ query: 'FOR u IN users RETURN u', batchSize: 5000 })
+ *   .on('data', (docs) => docs.forEach(exportDocument))
+ *   .on('end', () => console.log('done'));
+ */
+Connection.prototype.queryStream = function(options) {
+    if (typeof options == 'string') {
+        options = { query: options };
+    }
+    const conn = this;
+    const database = options.database;
+    const paths = options.paths ? ['error', 'errorMessage', 'hasMore', 'id'].concat(options.paths.map((p) => `result.${p}`)) : undefined;
+    let cursorId;
+    let fetching = false;
+    let destroyed = false;
+    // Release the cursor on the server
+    const deleteCursor = (id) => conn.delete({ path: `/_api/cursor/${id}`, database: database }, () => {});
+    const stream = new Readable({
+        objectMode: true,
+        highWaterMark: options.highWaterMark || 2,
+        read() {
+            if (fetching) {
+                return;
+            }
+            fetching = true;
+            let req;
+            if (cursorId === undefined) {
+                req = conn.post({ path: '/_api/cursor', database: database }, {
+                    query: options.query,
+                    bindVars: options.bindVars || {},
+                    batchSize: options.batchSize || 1000
+                });
+            } else {
+                req = conn.put({ path: `/_api/cursor/${cursorId}`, database: database });
+            }
+            req.then((res) => {
+                fetching = false;
+                const body = paths ? res.project(paths) : res.body;
+                res.release();
+                if (destroyed) {
+                    // destroyed while the request was in flight, so the
+                    // cursor (if any) has not been deleted yet
+                    if (!body.error && body.hasMore) {
+                        deleteCursor(body.id);
+                    }
+                    return;
+                }
+                if (body.error) {
+                    cursorId = undefined;
+                    stream.destroy(new Error(body.errorMessage));
+                    return;
+                }
+                cursorId = body.hasMore ? body.id : undefined;
+                stream.push(body.result);
+                if (cursorId === undefined) {
+                    stream.push(null);
+                }
+            }).catch((err) => {
+                fetching = false;
+                if (destroyed && cursorId !== undefined) {
+                    deleteCursor(cursorId);
+                    cursorId = undefined;
+                }
+                stream.destroy(err);
+            });
+        },
+        destroy(err, cb) {
+            destroyed = true;
+            if (cursorId !== undefined && !fetching) {
+                deleteCursor(cursorId);
+                cursorId = undefined;
+            }
+            cb(err);
+        }
+    });
+    return stream;
+}
+
 /**
  * @callback RequestCallback
  * @name RequestCallback
@@ -428,6 +920,23 @@ Connection.prototype.sendRequest = function(req, cb) {
  * @property {string} contentType - Content type of the request.
  * @property {Object} query - Query parameters of the request.
  * @property {Object} header - Header meta data of the request.
+ * @property {string|Buffer} json - JSON text to send as body (see {@link Request#addJsonBody}).
+ * @property {string|Number} file - Path or descriptor of a file to send as body (see {@link Request#addFile}).
+ * @property {boolean} renderJson - Render a velocypack response as JSON text on the IO thread (see {@link Response#jsonBuffer}).
+ * @property {boolean} idempotent - Allow hedging of a request that is not a GET (see {@link Request}).
+ * @property {boolean} parseJson - Parse a JSON response into velocypack on the IO thread (see {@link Request}).
+ */
+
+/**
+ * Options passed to queryStream.
+ * @typedef {Object} QueryStreamOptions
+ * @name QueryStreamOptions
+ * @property {string} query - AQL query.
+ * @property {Object} bindVars - Bind parameters of the query.
+ * @property {string} database - Name of the database the query runs in.
+ * @property {Number} batchSize - Number of documents per batch (defaults to 1000).
+ * @property {Number} highWaterMark - Number of batches to buffer in the stream (defaults to 2).
+ * @property {string[]} paths - Decode only these attribute paths of each document (see {@link Response#project}).
  */
 
 module.exports = fuerte;
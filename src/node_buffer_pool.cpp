@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <unordered_set>
+
+#include <uv.h>
+
+#include "node_buffer_pool.h"
+
+namespace arangodb { namespace fuerte { namespace js {
+
+// interval of trimIdle (ms)
+static uint64_t const TrimInterval = 5000;
+
+// pools of all threads, for trimIdle
+static std::mutex PoolsMutex;
+static std::unordered_set<BufferPool*> Pools;
+
+///////////////////////////////////////////////////////////////////////////////
+// BufferPool /////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+BufferPool& BufferPool::instance() {
+  static thread_local BufferPool pool;
+  return pool;
+}
+
+BufferPool::BufferPool()
+  : _recentCount(0), _stats{0, 0, 0, 0}, _acquiredAtTrim(0) {
+  std::lock_guard<std::mutex> guard(PoolsMutex);
+  Pools.insert(this);
+}
+
+BufferPool::~BufferPool() {
+  std::lock_guard<std::mutex> guard(PoolsMutex);
+  Pools.erase(this);
+}
+
+// sizeClass returns the smallest class that holds size bytes.
+std::size_t BufferPool::sizeClass(std::size_t size) {
+  std::size_t c = MinClass;
+  while (c < MaxClass && (std::size_t(1) << c) < size) {
+    ++c;
+  }
+  return c;
+}
+
+std::size_t BufferPool::wantedClass() const {
+  auto const n = std::min(_recentCount, RecentValues);
+  if (n == 0) {
+    return MinClass;
+  }
+  std::array<uint8_t, RecentValues> recent = _recent;
+  std::nth_element(recent.begin(), recent.begin() + n / 2, recent.begin() + n);
+  return recent[n / 2];
+}
+
+std::shared_ptr<VPBuffer> BufferPool::acquire() {
+  std::lock_guard<std::mutex> guard(_mutex);
+  auto const wanted = wantedClass();
+  // accept buffers up to 4 times larger than needed
+  for (auto c = wanted; c <= MaxClass && c <= wanted + 2; ++c) {
+    auto& buffers = _classes[c - MinClass];
+    if (!buffers.empty()) {
+      auto buffer = std::move(buffers.back());
+      buffers.pop_back();
+      _stats.retainedBytes -= buffer->capacity();
+      _stats.retainedBuffers--;
+      _stats.hits++;
+      return buffer;
+    }
+  }
+  _stats.misses++;
+  auto buffer = std::make_shared<VPBuffer>();
+  buffer->reserve(std::size_t(1) << wanted);
+  return buffer;
+}
+
+void BufferPool::release(std::shared_ptr<VPBuffer>&& buffer, std::size_t used) {
+  std::lock_guard<std::mutex> guard(_mutex);
+  // follow the size of recently encoded values
+  _recent[_recentCount++ % RecentValues] = static_cast<uint8_t>(sizeClass(used));
+
+  if (!buffer || buffer.use_count() != 1) {
+    // still in use elsewhere
+    return;
+  }
+  auto const capacity = static_cast<std::size_t>(buffer->capacity());
+  if (capacity < (std::size_t(1) << MinClass) ||
+      capacity > (std::size_t(1) << MaxClass)) {
+    return;
+  }
+  // largest class that is fully covered by the buffer
+  auto c = sizeClass(capacity);
+  if ((std::size_t(1) << c) > capacity) {
+    --c;
+  }
+  auto& buffers = _classes[c - MinClass];
+  if (buffers.size() >= BuffersPerClass ||
+      _stats.retainedBytes + capacity > MaxRetainedBytes) {
+    return;
+  }
+  buffer->reset();
+  buffers.push_back(std::move(buffer));
+  _stats.retainedBytes += capacity;
+  _stats.retainedBuffers++;
+}
+
+void BufferPool::trim(std::size_t maxBytes) {
+  std::lock_guard<std::mutex> guard(_mutex);
+  trimLocked(maxBytes);
+}
+
+void BufferPool::trimLocked(std::size_t maxBytes) {
+  // drop the largest buffers first
+  for (auto c = _classes.size(); c > 0 && _stats.retainedBytes > maxBytes; --c) {
+    auto& buffers = _classes[c - 1];
+    while (!buffers.empty() && _stats.retainedBytes > maxBytes) {
+      _stats.retainedBytes -= buffers.back()->capacity();
+      _stats.retainedBuffers--;
+      buffers.pop_back();
+    }
+  }
+}
+
+void BufferPool::trimIdle() {
+  std::lock_guard<std::mutex> guard(PoolsMutex);
+  for (auto pool : Pools) {
+    std::lock_guard<std::mutex> poolGuard(pool->_mutex);
+    auto const acquired = pool->_stats.hits + pool->_stats.misses;
+    if (acquired == pool->_acquiredAtTrim) {
+      pool->trimLocked(pool->_stats.retainedBytes / 2);
+    }
+    pool->_acquiredAtTrim = acquired;
+  }
+}
+
+BufferPool::Stats BufferPool::stats() const {
+  std::lock_guard<std::mutex> guard(_mutex);
+  return _stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PooledBuilder //////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+PooledBuilder::PooledBuilder()
+  : _buffer(BufferPool::instance().acquire()),
+    _builder(new VPackBuilder(_buffer, TRI_EncodeOptions())) {}
+
+PooledBuilder::~PooledBuilder() {
+  std::size_t used = _builder->isClosed() ? _builder->size() : 0;
+  // the builder must let go of the buffer before it can be reused
+  _builder.reset();
+  BufferPool::instance().release(std::move(_buffer), used);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// node interface /////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static void trimBufferPools(uv_timer_t*) {
+  BufferPool::trimIdle();
+}
+
+NAN_METHOD(vpackPoolStats) {
+  auto stats = BufferPool::instance().stats();
+  auto result = Nan::New<v8::Object>();
+  Nan::Set(result, Nan::New("hits").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(stats.hits)));
+  Nan::Set(result, Nan::New("misses").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(stats.misses)));
+  Nan::Set(result, Nan::New("retainedBytes").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(stats.retainedBytes)));
+  Nan::Set(result, Nan::New("retainedBuffers").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(stats.retainedBuffers)));
+  info.GetReturnValue().Set(result);
+}
+
+NAN_MODULE_INIT(InitBufferPool) {
+  // one timer (on the first event loop) trims the pools of all threads,
+  // it does not keep the event loop alive
+  static uv_timer_t* timer = nullptr;
+  if (timer == nullptr) {
+    timer = new uv_timer_t;
+    uv_timer_init(uv_default_loop(), timer);
+    uv_timer_start(timer, trimBufferPools, TrimInterval, TrimInterval);
+    uv_unref(reinterpret_cast<uv_handle_t*>(timer));
+  }
+  NAN_EXPORT(target, vpackPoolStats);
+}
+
+}}}
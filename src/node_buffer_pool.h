@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#ifndef FUERTE_NODE_BUFFER_POOL_H
+#define FUERTE_NODE_BUFFER_POOL_H
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "node_vpack.h"
+
+namespace arangodb { namespace fuerte { namespace js {
+
+// BufferPool keeps velocypack buffers of the encoders for reuse, so that
+// encoding in steady state does not allocate (or grow) buffers.
+// Buffers are kept per size class (powers of 2). New buffers are sized
+// after the median size class of the recently encoded values, so a single
+// large value does not make the following small ones allocate large
+// buffers. There is one pool per thread. Pools that were not used for a
+// while are trimmed from a timer on the main event loop (see trimIdle).
+class BufferPool {
+public:
+  struct Stats {
+    uint64_t hits;
+    uint64_t misses;
+    std::size_t retainedBytes;
+    std::size_t retainedBuffers;
+  };
+
+  // instance returns the pool of the current thread.
+  static BufferPool& instance();
+
+  // acquire returns an empty buffer, preferably from the pool.
+  std::shared_ptr<VPBuffer> acquire();
+  // release returns a buffer to the pool after `used` bytes were written to it.
+  void release(std::shared_ptr<VPBuffer>&& buffer, std::size_t used);
+  // trim drops retained buffers until at most maxBytes are retained.
+  void trim(std::size_t maxBytes);
+  // trimIdle halves the retained buffers of every pool (of any thread)
+  // that has not been used since the previous call.
+  static void trimIdle();
+
+  Stats stats() const;
+
+  ~BufferPool();
+  BufferPool(BufferPool const&) = delete;
+  BufferPool& operator=(BufferPool const&) = delete;
+
+private:
+  BufferPool();
+  void trimLocked(std::size_t maxBytes);
+
+  static std::size_t const MinClass = 10;      // 1KB
+  static std::size_t const MaxClass = 26;      // 64MB
+  static std::size_t const BuffersPerClass = 4;
+  static std::size_t const MaxRetainedBytes = std::size_t(128) << 20;
+
+  static std::size_t const RecentValues = 15;
+
+  static std::size_t sizeClass(std::size_t size);
+  // median size class of the recently encoded values
+  std::size_t wantedClass() const;
+
+  std::array<std::vector<std::shared_ptr<VPBuffer>>, MaxClass - MinClass + 1> _classes;
+  // size classes of the recently encoded values (ring buffer)
+  std::array<uint8_t, RecentValues> _recent;
+  std::size_t _recentCount;
+  Stats _stats;
+  // number of acquired buffers at the previous trimIdle
+  uint64_t _acquiredAtTrim;
+  // the owning thread only contends with trimIdle
+  mutable std::mutex _mutex;
+};
+
+// PooledBuilder is a VPackBuilder that works on a buffer of the BufferPool
+// of the current thread. The buffer is returned to the pool on destruction.
+class PooledBuilder {
+public:
+  PooledBuilder();
+  ~PooledBuilder();
+  PooledBuilder(PooledBuilder const&) = delete;
+  PooledBuilder& operator=(PooledBuilder const&) = delete;
+
+  VPackBuilder& operator*() { return *_builder; }
+  VPackBuilder* operator->() { return _builder.get(); }
+
+private:
+  std::shared_ptr<VPBuffer> _buffer;
+  std::unique_ptr<VPackBuilder> _builder;
+};
+
+NAN_METHOD(vpackPoolStats);
+NAN_MODULE_INIT(InitBufferPool);
+
+}}}
+#endif
@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+
+#include <memory>
+#include <string>
+
+#include "node_builder.h"
+
+namespace arangodb { namespace fuerte { namespace js {
+
+// open an array or object, with an optional attribute name as first argument
+static void openCompound(Nan::FunctionCallbackInfo<v8::Value> const& info,
+                         VPackBuilder* builder, VPackValueType type) {
+  if (info.Length() > 0) {
+    builder->add(to<std::string>(info[0]), VPackValue(type));
+  } else {
+    builder->add(VPackValue(type));
+  }
+}
+
+NAN_METHOD(NBuilder::New) {
+  if (info.IsConstructCall()) {
+    auto obj = new NBuilder();
+    obj->Wrap(info.This());
+    info.GetReturnValue().Set(info.This());
+  } else {
+    info.GetReturnValue().Set(NBuilder::NewInstance().ToLocalChecked());
+  }
+}
+
+NAN_METHOD(NBuilder::openArray) {
+  try {
+    openCompound(info, self(info), VPackValueType::Array);
+    info.GetReturnValue().Set(info.This());
+  } catch(std::exception const& e) {
+    std::string msg = std::string("Builder.openArray binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_METHOD(NBuilder::openObject) {
+  try {
+    openCompound(info, self(info), VPackValueType::Object);
+    info.GetReturnValue().Set(info.This());
+  } catch(std::exception const& e) {
+    std::string msg = std::string("Builder.openObject binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_METHOD(NBuilder::add) {
+  try {
+    if (info.Length() != 2) {
+      Nan::ThrowTypeError("Wrong number of Arguments, use addValue(value) outside of objects");
+      return;
+    }
+    auto key = to<std::string>(info[0]);
+    auto tri = TRI_V8ToVPack(info.GetIsolate(), *self(info), arangodb::StringRef(key), info[1]);
+    if (tri != TRI_ERROR_NO_ERROR) {
+      std::string errorMessage = std::string("Builder.add: Error while encoding: TRI_ERROR(") + std::to_string(tri) + ")";
+      Nan::ThrowError(errorMessage.c_str());
+      return;
+    }
+    info.GetReturnValue().Set(info.This());
+  } catch(std::exception const& e) {
+    std::string msg = std::string("Builder.add binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_METHOD(NBuilder::addValue) {
+  try {
+    if (info.Length() != 1) {
+      Nan::ThrowTypeError("Wrong number of Arguments, use add(key, value) inside of objects");
+      return;
+    }
+    auto tri = TRI_V8ToVPack(info.GetIsolate(), *self(info), info[0], false);
+    if (tri != TRI_ERROR_NO_ERROR) {
+      std::string errorMessage = std::string("Builder.addValue: Error while encoding: TRI_ERROR(") + std::to_string(tri) + ")";
+      Nan::ThrowError(errorMessage.c_str());
+      return;
+    }
+    info.GetReturnValue().Set(info.This());
+  } catch(std::exception const& e) {
+    std::string msg = std::string("Builder.addValue binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_METHOD(NBuilder::close) {
+  try {
+    self(info)->close();
+    info.GetReturnValue().Set(info.This());
+  } catch(std::exception const& e) {
+    std::string msg = std::string("Builder.close binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_METHOD(NBuilder::clear) {
+  try {
+    self(info)->clear();
+    info.GetReturnValue().Set(info.This());
+  } catch(std::exception const& e) {
+    std::string msg = std::string("Builder.clear binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_METHOD(NBuilder::toBuffer) {
+  try {
+    auto builder = self(info);
+    if (!builder->isClosed()) {
+      Nan::ThrowError("Builder.toBuffer: builder is not closed");
+      return;
+    }
+    auto slice = builder->slice();
+    info.GetReturnValue().Set(Nan::CopyBuffer(slice.startAs<char>(), slice.byteSize()).ToLocalChecked());
+  } catch(std::exception const& e) {
+    std::string msg = std::string("Builder.toBuffer binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_GETTER(NBuilder::getIsClosed) {
+  try {
+    info.GetReturnValue().Set(Nan::New<v8::Boolean>(self(info)->isClosed()));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("Builder.isClosed binding failed with exception");
+  }
+}
+
+NAN_GETTER(NBuilder::getByteSize) {
+  try {
+    auto builder = self(info);
+    if (builder->isClosed()) {
+      auto size = static_cast<double>(builder->size());
+      info.GetReturnValue().Set(Nan::New<v8::Number>(size));
+    } else {
+      info.GetReturnValue().Set(Nan::Undefined());
+    }
+  } catch(std::exception const& e) {
+    Nan::ThrowError("Builder.byteSize binding failed with exception");
+  }
+}
+
+}}}
@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#ifndef FUERTE_NODE_BUILDER_H
+#define FUERTE_NODE_BUILDER_H
+
+#include "node_upstream.h"
+#include "node_vpack.h"
+#include "object_wrap.h"
+
+namespace arangodb { namespace fuerte { namespace js {
+
+// NBuilder is a node wrapper around the velocypack Builder class.
+// It allows building (large) velocypack values incrementally, without
+// first creating the entire value in JS.
+class NBuilder : public ObjectWrap<NBuilder, VPackBuilder, std::unique_ptr<VPackBuilder>> {
+  NBuilder(): ObjectWrap(std::unique_ptr<VPackBuilder>(new VPackBuilder(TRI_EncodeOptions()))) {}
+
+public:
+  static NAN_MODULE_INIT(Init) {
+    auto tpl = Nan::New<v8::FunctionTemplate>(New);
+    tpl->SetClassName(Nan::New("Builder").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    Nan::SetPrototypeMethod(tpl, "openArray", NBuilder::openArray);
+    Nan::SetPrototypeMethod(tpl, "openObject", NBuilder::openObject);
+    Nan::SetPrototypeMethod(tpl, "add", NBuilder::add);
+    Nan::SetPrototypeMethod(tpl, "addValue", NBuilder::addValue);
+    Nan::SetPrototypeMethod(tpl, "close", NBuilder::close);
+    Nan::SetPrototypeMethod(tpl, "clear", NBuilder::clear);
+    Nan::SetPrototypeMethod(tpl, "toBuffer", NBuilder::toBuffer);
+
+    auto itpl = tpl->InstanceTemplate();
+    Nan::SetAccessor(itpl, toString("isClosed"), NBuilder::getIsClosed);
+    Nan::SetAccessor(itpl, toString("byteSize"), NBuilder::getByteSize);
+
+    initClass("Builder", target, tpl);
+  }
+
+  // Node constructor
+  static NAN_METHOD(New);
+  // Open an array, optionally as member `key` of the open object.
+  static NAN_METHOD(openArray);
+  // Open an object, optionally as member `key` of the open object.
+  static NAN_METHOD(openObject);
+  // Add a JS value as member `key` of the open object: add(key, value).
+  static NAN_METHOD(add);
+  // Add a JS value to the open array (or as top level value): addValue(value).
+  static NAN_METHOD(addValue);
+  // Close the innermost open array or object.
+  static NAN_METHOD(close);
+  // Remove all content, so the builder can be reused.
+  static NAN_METHOD(clear);
+  // Return a copy of the built slice in a Buffer.
+  static NAN_METHOD(toBuffer);
+
+  // Returns true if all arrays & objects have been closed.
+  static NAN_GETTER(getIsClosed);
+  // Returns the size of the built slice (undefined while still open).
+  static NAN_GETTER(getByteSize);
+};
+
+}}}
+#endif
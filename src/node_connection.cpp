@@ -27,13 +27,16 @@
 #include <atomic>
 #include <thread>
 #include <string>
+#include <vector>
 #include <stdlib.h>
 
 #include <fuerte/FuerteLogger.h>
 #include <fuerte/helper.h>
+#include <velocypack/Parser.h>
 
 #include "node_connection.h"
 #include "node_connection_builder.h"
+#include "node_mapped_file.h"
 #include "node_request.h"
 #include "node_response.h"
 
@@ -65,12 +68,30 @@ NAN_METHOD(NConnection::New) {
     if (info.IsConstructCall()) {
       auto obj = new NConnection();
       if (info[0]->IsObject()) { // NConnectionBuilderObject -- exact type check?
-        auto conn = unwrap<NConnectionBuilder>(info[0])->cppClass()->connect(eventLoopService_);
-        if (conn == nullptr) {
+        auto builder = unwrap<NConnectionBuilder>(info[0]);
+        // one endpoint per host
+        std::vector<fu::ConnectionBuilder> endpoints;
+        if (builder->_hosts.empty()) {
+          endpoints.push_back(*builder->cppClass());
+        }
+        for (auto const& host : builder->_hosts) {
+          endpoints.push_back(*builder->cppClass());
+          endpoints.back().host(host);
+        }
+        std::shared_ptr<ConnectionPool> pool;
+        try {
+          pool = std::make_shared<ConnectionPool>(endpoints, eventLoopService_, builder->_poolSize);
+        } catch (std::exception const& e) {
           Nan::ThrowError("Connection.New binding failed with exception - check connection string");
           return;
         }
-        obj->setCppClass(conn);
+        obj->setCppClass(pool);
+        if (builder->_resolveCollectionNames) {
+          obj->_collectionNames = std::make_shared<CollectionNameResolver>();
+        }
+        obj->_retainRequest = builder->_retainRequest;
+        obj->_spillThreshold = builder->_spillThreshold;
+        obj->_hedgePercentile = builder->_hedgePercentile;
       }
       obj->Wrap(info.This());
       info.GetReturnValue().Set(info.This());
@@ -92,6 +113,24 @@ NAN_GETTER(NConnection::getRequestsLeft) {
   }
 }
 
+NAN_GETTER(NConnection::getHealthyEndpoints) {
+  try {
+    auto result = self(info)->healthyEndpoints();
+    info.GetReturnValue().Set(Nan::New<v8::Uint32>(static_cast<std::uint32_t>(result)));
+  } catch(std::exception const& e){
+    Nan::ThrowError("Connection.healthyEndpoints binding failed with exception");
+  }
+}
+
+NAN_GETTER(NConnection::getPoolSize) {
+  try {
+    auto result = self(info)->size();
+    info.GetReturnValue().Set(Nan::New<v8::Uint32>(static_cast<std::uint32_t>(result)));
+  } catch(std::exception const& e){
+    Nan::ThrowError("Connection.poolSize binding failed with exception");
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // SendRequest ////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -105,7 +144,64 @@ const std::string callbackErrorMessage(
   "##################################################\n"
 );
 
+class PendingRequest;
+
+// CompletionQueue hands finished requests from the IO threads to the main
+// event loop. All requests share one async handle, so a burst of responses
+// wakes up the event loop once instead of once per request.
+class CompletionQueue {
+ public:
+  // instance returns the queue, it must first be called on the main thread.
+  static CompletionQueue& instance() {
+    static CompletionQueue queue;
+    return queue;
+  }
+
+  // started is called on the main event loop for every request that will
+  // be pushed, it keeps the event loop alive until the request is done.
+  void started() {
+    if (_pending++ == 0) {
+      uv_ref(reinterpret_cast<uv_handle_t*>(&_async));
+    }
+  }
+
+  // push is called on any thread when a request has finished.
+  void push(PendingRequest* penReq) {
+    bool wakeup;
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      // an earlier push has already woken up the event loop
+      wakeup = _done.empty();
+      _done.push_back(penReq);
+    }
+    if (wakeup) {
+      uv_async_send(&_async);
+    }
+  }
+
+ private:
+  CompletionQueue() : _pending(0) {
+    uv_async_init(uv_default_loop(), &_async, drainStatic);
+    _async.data = this;
+    uv_unref(reinterpret_cast<uv_handle_t*>(&_async));
+  }
+
+  static NAUV_WORK_CB(drainStatic) {
+    static_cast<CompletionQueue*>(async->data)->drain();
+  }
+
+  // drain is called on the main event loop.
+  void drain();
+
+  std::mutex _mutex;
+  std::vector<PendingRequest*> _done;
+  std::vector<PendingRequest*> _draining;
+  uv_async_t _async;
+  std::size_t _pending; // main event loop only
+};
+
 class PendingRequest {
+  friend class CompletionQueue;
  public:
   PendingRequest(v8::Local<v8::Value> const& request, v8::Local<v8::Value> const& callback) :
     jsRequest(v8::Local<v8::Object>::Cast(request)),
@@ -113,46 +209,245 @@ class PendingRequest {
     NRequest::CheckedUnwrap(Nan::New(jsRequest));
   }
 
-  // Initialize the async handle (cannot be called in ctor due to shared_from_this)
-  void InitAsync() {
-    uv_async_init(uv_default_loop(), &async_handle, uvCallbackStatic);
-    async_handle.data = this;
-  }
-
   // Start sending the request
   void Start(NConnection* conn) {
     // Clone the request so we keep the one in the JS object alive.
     v8::Local<v8::Object> locJsReq = New(jsRequest);
     auto jsReq = Nan::ObjectWrap::Unwrap<NRequest>(locJsReq);
     auto req = std::unique_ptr<fu::Request>(new fu::Request(*(jsReq->cppClass()))); 
-    conn->cppClass()->sendRequest(std::move(req), [this](unsigned err, std::unique_ptr<fu::Request> creq, std::unique_ptr<fu::Response> cres){
-      cppCallback(err, std::move(creq), std::move(cres));
-    });
+    connection = conn->cppPtr();
+    collectionNames = conn->_collectionNames;
+    renderJson = jsReq->_renderJson;
+    parseJson = jsReq->_parseJson;
+    retainRequest = conn->_retainRequest;
+    spillThreshold = conn->_spillThreshold;
+    if (conn->_hedgePercentile > 0 &&
+        (jsReq->_idempotent || req->header.restVerb == fu::RestVerb::Get)) {
+      hedgePercentile = conn->_hedgePercentile;
+    }
+    if (jsReq->_jsonBody || jsReq->_fileBody) {
+      // Prepare the body on a worker thread, send when done
+      jsonBody = jsReq->_jsonBody;
+      encodeOptions = *TRI_EncodeOptions();
+      fileBody = jsReq->_fileBody;
+      cppRequest = std::move(req);
+      body_work.data = this;
+      uv_queue_work(uv_default_loop(), &body_work, prepareBody, prepareBodyDone);
+      return;
+    }
+    Send(std::move(req));
   }
 
  private:
+  // Send the request on the connection
+  void Send(std::unique_ptr<fu::Request> req) {
+    auto delay = hedgePercentile > 0 ? connection->latencyPercentile(*req, hedgePercentile) : 0;
+    if (delay <= 0) {
+      connection->sendRequest(std::move(req), [this](unsigned err, std::unique_ptr<fu::Request> creq, std::unique_ptr<fu::Response> cres){
+        cppCallback(err, std::move(creq), std::move(cres));
+      });
+      return;
+    }
+    // Send a copy when the request takes longer than usual, the first
+    // successful response wins.
+    hedge = std::make_shared<ConnectionPool::Hedge>();
+    hedgeRequest.reset(new fu::Request(*req));
+    uv_timer_init(uv_default_loop(), &hedge_timer);
+    hedge_timer.data = this;
+    hedgeTimerStarted = true;
+    uv_timer_start(&hedge_timer, hedgeStatic, static_cast<uint64_t>(delay) + 1, 0);
+    connection->sendRequest(std::move(req), hedgeCallback(), hedge);
+  }
+
+  // hedgeCallback returns the callback of the copies of a hedged request,
+  // the pool passes on only one of their responses and drops the others
+  // on the IO thread.
+  PoolCallback hedgeCallback() {
+    return [this](unsigned err, std::unique_ptr<fu::Request> creq, std::unique_ptr<fu::Response> cres){
+      cppCallback(err, std::move(creq), std::move(cres));
+    };
+  }
+
+  // hedgeStatic is called on the main event loop when the hedge delay has passed.
+  static void hedgeStatic(uv_timer_t* timer) {
+    auto penReq = static_cast<PendingRequest*>(timer->data);
+    // the pool skips the copy if there is no other connection to send it on
+    penReq->connection->hedgeRequest(std::move(penReq->hedgeRequest), penReq->hedgeCallback(), penReq->hedge);
+  }
+
+  // prepareBody is called on a libuv worker thread.
+  // It adds the JSON body (converted to velocypack) or the file body to the request.
+  static void prepareBody(uv_work_t* work) {
+    auto penReq = static_cast<PendingRequest*>(work->data);
+    if (penReq->jsonBody) {
+      try {
+        VPackParser parser(&penReq->encodeOptions);
+        parser.parse(penReq->jsonBody->data(), penReq->jsonBody->size());
+        auto builder = parser.steal();
+        penReq->cppRequest->addVPack(builder->slice());
+        penReq->cppRequest->contentType(fu::to_string(fu::ContentType::VPack));
+      } catch (std::exception const& e) {
+        penReq->bodyError = std::string("Request.addJsonBody: invalid JSON: ") + e.what();
+      }
+    }
+    if (penReq->fileBody) {
+      try {
+        readFileBody(*penReq->fileBody, *penReq->cppRequest);
+      } catch (std::exception const& e) {
+        penReq->bodyError = std::string("Request.addFile: ") + e.what();
+      }
+    }
+  }
+
+  // prepareBodyDone is called on the main event loop.
+  static void prepareBodyDone(uv_work_t* work, int status) {
+    auto penReq = static_cast<PendingRequest*>(work->data);
+    penReq->jsonBody.reset();
+    penReq->fileBody.reset();
+    if (status != 0 && penReq->bodyError.empty()) {
+      penReq->bodyError = "Request body preparation was cancelled";
+    }
+    if (!penReq->bodyError.empty()) {
+      // Report the error through the callback
+      CompletionQueue::instance().push(penReq);
+      return;
+    }
+    penReq->Send(std::move(penReq->cppRequest));
+  }
+
   // cppCallback is called on any of the fuerte EventLoopService threads.
   void cppCallback(unsigned err, std::unique_ptr<fu::Request> creq, std::unique_ptr<fu::Response> cres) {
     // Save data 
     this->error = err; 
     this->cppResponse = std::move(cres);
+    boost::optional<std::string> database;
+    if (creq) {
+      database = creq->header.database;
+    }
+    if (needsCollectionNames(database)) {
+      // Fetch collection names first, then continue on the main event loop
+      refreshCollectionNames(database);
+      return;
+    }
+    complete();
+  }
+
+  // complete finishes the work on the IO thread and triggers the callback
+  // on the main event loop.
+  void complete() {
+    // A payload that will be spilled is neither parsed nor rendered here,
+    // that would keep a second copy of it in memory.
+    spill = spillThreshold > 0 && cppResponse &&
+      boost::asio::buffer_size(cppResponse->payload()) > spillThreshold;
+    if (!spill && parseJson && cppResponse && cppResponse->isContentTypeJSON()) {
+      try {
+        parsedJson = NResponse::parseJson(cppResponse->payload());
+      } catch (...) {
+        // Response.body parses again and reports the error
+      }
+    }
+    if (!spill && renderJson && cppResponse && cppResponse->isContentTypeVPack()) {
+      try {
+        auto slices = cppResponse->slices();
+        if (!slices.empty()) {
+          auto options = collectionNames ? collectionNames->options() : TRI_DecodeOptions();
+          auto rendered = std::make_shared<std::string>();
+          TRI_VPackToJson(slices, options, *rendered);
+          json = std::move(rendered);
+        }
+      } catch (...) {
+        // Response.jsonBuffer renders again and reports the error
+      }
+    }
     // Trigger callback on main event loop
-    uv_async_send(&async_handle);
+    CompletionQueue::instance().push(this);
+  }
+
+  // needsCollectionNames returns true if the response contains custom _id
+  // values of collections that are not yet known by the resolver.
+  bool needsCollectionNames(boost::optional<std::string> const& database) {
+    if (!collectionNames || !cppResponse || !cppResponse->isContentTypeVPack()) {
+      return false;
+    }
+    bool unknown = false;
+    try {
+      for (auto const& slice : cppResponse->slices()) {
+        unknown = collectionNames->hasUnknownIds(database ? *database : std::string(), slice) || unknown;
+      }
+    } catch (...) {
+      // leave invalid payloads to the decoder
+    }
+    return unknown;
   }
 
-  // Static UV callback.
-  static NAUV_WORK_CB(uvCallbackStatic) {
-    // Invoke actual callback handler (on event loop)
-    auto penReq = static_cast<PendingRequest*>(async->data);
-    penReq->uvCallback();
-    // Close handle
-    uv_close((uv_handle_t*)async, uvCleanup);
+  // refreshCollectionNames (re)loads all collection names of the database
+  // into the resolver and triggers the callback on the main event loop.
+  void refreshCollectionNames(boost::optional<std::string> const& database) {
+    auto resolver = collectionNames;
+    auto name = database ? *database : std::string();
+    bool start = resolver->waitForRefresh(name, [this]() {
+      complete();
+    });
+    if (!start) {
+      // Another request is already refreshing this database
+      return;
+    }
+    auto req = std::unique_ptr<fu::Request>(new fu::Request());
+    req->header.restVerb = fu::RestVerb::Get;
+    req->header.path = std::string("/_api/collection");
+    req->header.database = database;
+    req->acceptType(fu::to_string(fu::ContentType::VPack));
+    connection->sendRequest(std::move(req), [resolver, name](unsigned err, std::unique_ptr<fu::Request>, std::unique_ptr<fu::Response> res) {
+      try {
+        if (err == 0 && res && res->isContentTypeVPack() && !res->slices().empty()) {
+          resolver->refresh(name, TRI_VPackGet(res->slices()[0], "result", TRI_DecodeOptions()));
+          return;
+        }
+      } catch (...) {
+      }
+      // Keep the cache, but release the waiting requests
+      resolver->refresh(name, VPackSlice());
+    });
+  }
+
+  // finish is called on the main event loop (by the CompletionQueue).
+  // It invokes the JS callback and deletes the pending request.
+  void finish() {
+    if (spill) {
+      // Write the payload to the temp file on a libuv worker thread first,
+      // the IO threads must not block on the disk.
+      spill = false;
+      spill_work.data = this;
+      uv_queue_work(uv_default_loop(), &spill_work, spillPayload, spillPayloadDone);
+      return;
+    }
+    uvCallback();
+    if (hedgeTimerStarted) {
+      uv_timer_stop(&hedge_timer);
+      uv_close((uv_handle_t*)&hedge_timer, uvCleanup);
+      return;
+    }
+    delete this;
+  }
+
+  // spillPayload is called on a libuv worker thread.
+  static void spillPayload(uv_work_t* work) {
+    auto penReq = static_cast<PendingRequest*>(work->data);
+    try {
+      penReq->spilled = NResponse::spillPayload(*penReq->cppResponse);
+    } catch (...) {
+      // keep the payload in memory
+    }
+  }
+
+  // spillPayloadDone is called on the main event loop.
+  static void spillPayloadDone(uv_work_t* work, int status) {
+    static_cast<PendingRequest*>(work->data)->finish();
   }
 
   // Static UV cleanup callback.
   static void uvCleanup(uv_handle_t *handle) {
-    auto penReq = static_cast<PendingRequest*>(handle->data);
-    delete penReq;
+    delete static_cast<PendingRequest*>(handle->data);
   }
 
   // uvCallback is called on the main event loop.
@@ -164,9 +459,16 @@ class PendingRequest {
     if (cppResponse) {
       // Create Response object
       auto resObj = NResponse::NewInstance().ToLocalChecked();
-      unwrap<NResponse>(resObj)->setCppClass(std::move(cppResponse));
+      auto nres = unwrap<NResponse>(resObj);
+      nres->setResponse(std::move(cppResponse));
+      nres->_spilled = std::move(spilled);
+      nres->_collectionNames = collectionNames;
+      nres->setJson(std::move(json));
+      nres->setParsedJson(std::move(parsedJson));
       // Store request in response 
-      resObj->Set(Nan::New("request").ToLocalChecked(), Nan::New(jsRequest));
+      if (retainRequest) {
+        NResponse::setRequest(resObj, Nan::New(jsRequest));
+      }
       response = resObj;
     } else {
       response = Nan::Undefined();
@@ -175,18 +477,57 @@ class PendingRequest {
     // Call callback
     const unsigned argc = 2;
     v8::Local<v8::Value> argv[argc] = { Nan::New<v8::Integer>(error), response };
+    if (!bodyError.empty()) {
+      argv[0] = Nan::Error(bodyError.c_str());
+    }
     // call
     jsCallback.Call(argc, argv);
   }
 
   // members
+  std::shared_ptr<ConnectionPool> connection;
+  std::shared_ptr<CollectionNameResolver> collectionNames;
   Nan::Persistent<v8::Object> jsRequest;
   Nan::Callback jsCallback;
-  uv_async_t async_handle;
-  unsigned error;
+  uv_timer_t hedge_timer;
+  bool hedgeTimerStarted = false;
+  uv_work_t body_work;
+  std::shared_ptr<std::string const> jsonBody;
+  VPackOptions encodeOptions;
+  std::shared_ptr<FileBody const> fileBody;
+  std::string bodyError;
+  std::unique_ptr<fu::Request> cppRequest;
+  bool renderJson = false;
+  bool parseJson = false;
+  bool retainRequest = true;
+  uint64_t spillThreshold = 0;
+  bool spill = false;
+  uv_work_t spill_work;
+  double hedgePercentile = 0;
+  std::shared_ptr<ConnectionPool::Hedge> hedge;
+  std::unique_ptr<fu::Request> hedgeRequest;
+  unsigned error = 0;
   std::unique_ptr<fu::Response> cppResponse;
+  std::shared_ptr<std::string> json;
+  std::shared_ptr<VPackBuilder> parsedJson;
+  std::shared_ptr<MappedFile> spilled;
 };
 
+void CompletionQueue::drain() {
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _draining.swap(_done);
+  }
+  for (auto penReq : _draining) {
+    penReq->finish();
+  }
+  _pending -= _draining.size();
+  _draining.clear();
+  if (_pending == 0) {
+    uv_unref(reinterpret_cast<uv_handle_t*>(&_async));
+  }
+}
+
 NAN_METHOD(NConnection::sendRequest) {
   try {
     // Check arguments
@@ -202,7 +543,7 @@ NAN_METHOD(NConnection::sendRequest) {
 
     // Create PendingRequest 
     auto penReq = new PendingRequest(info[0], info[1]);
-    penReq->InitAsync();
+    CompletionQueue::instance().started();
     // Start request
     auto conn = NConnection::CheckedUnwrap(info.Holder());
     penReq->Start(conn);
@@ -26,18 +26,21 @@
 #define FUERTE_NODE_CONNECTION_H
 
 #include <iostream>
+#include "node_connection_pool.h"
 #include "node_upstream.h"
+#include "node_vpack.h"
 #include "object_wrap.h"
 
 namespace arangodb { namespace fuerte { namespace js {
 
-// NConnection is a node wrapper around the fuerte Connection class.
-class NConnection : public ObjectWrap<NConnection, fu::Connection, std::shared_ptr<fu::Connection>> {
+// NConnection is a node wrapper around a pool of fuerte connections
+// (of a single connection by default).
+class NConnection : public ObjectWrap<NConnection, ConnectionPool, std::shared_ptr<ConnectionPool>> {
   friend class PendingRequest;
 public:
   friend class NConnectionBuilder;
-  NConnection(): ObjectWrap(nullptr) {}
-  NConnection(std::shared_ptr<::fu::Connection> conn): ObjectWrap(std::move(conn)) {}
+  NConnection(): ObjectWrap(nullptr), _retainRequest(true), _spillThreshold(0), _hedgePercentile(0) {}
+  NConnection(std::shared_ptr<ConnectionPool> pool): ObjectWrap(std::move(pool)) {}
 
   static NAN_MODULE_INIT(Init) {
     auto tpl = Nan::New<v8::FunctionTemplate>(New);
@@ -48,6 +51,8 @@ public:
 
     auto itpl = tpl->InstanceTemplate();
     Nan::SetAccessor(itpl, toString("requestsLeft"), NConnection::getRequestsLeft);
+    Nan::SetAccessor(itpl, toString("poolSize"), NConnection::getPoolSize);
+    Nan::SetAccessor(itpl, toString("healthyEndpoints"), NConnection::getHealthyEndpoints);
 
     initClass("Connection", target, tpl);
   }
@@ -56,8 +61,22 @@ public:
   static NAN_METHOD(New);
   // requestsLeft returns the number of unfinished requests
   static NAN_GETTER(getRequestsLeft);
+  // poolSize returns the number of open fuerte connections
+  static NAN_GETTER(getPoolSize);
+  // healthyEndpoints returns the number of servers that are not ejected
+  static NAN_GETTER(getHealthyEndpoints);
   // sendRequest starts sending a request
   static NAN_METHOD(sendRequest);
+
+private:
+  // Resolver for collection names in custom _id values (if enabled).
+  std::shared_ptr<CollectionNameResolver> _collectionNames;
+  // Store the request in its response (Response.request).
+  bool _retainRequest;
+  // Payload size above which responses are moved to a temp file (0 = never).
+  uint64_t _spillThreshold;
+  // Latency percentile after which idempotent requests are hedged (0 = never).
+  double _hedgePercentile;
 };
 
 }}}
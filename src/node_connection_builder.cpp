@@ -137,4 +137,140 @@ NAN_SETTER(NConnectionBuilder::setPassword) {
   }
 }
 
+NAN_GETTER(NConnectionBuilder::getResolveCollectionNames) {
+  try {
+    auto obj = CheckedUnwrap(info.Holder());
+    info.GetReturnValue().Set(Nan::New<v8::Boolean>(obj->_resolveCollectionNames));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.getResolveCollectionNames binding failed with exception");
+  }
+}
+
+NAN_SETTER(NConnectionBuilder::setResolveCollectionNames) {
+  try {
+    CheckedUnwrap(info.Holder())->_resolveCollectionNames = to<bool>(value);
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.setResolveCollectionNames binding failed with exception");
+  }
+}
+
+NAN_GETTER(NConnectionBuilder::getRetainRequest) {
+  try {
+    auto obj = CheckedUnwrap(info.Holder());
+    info.GetReturnValue().Set(Nan::New<v8::Boolean>(obj->_retainRequest));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.getRetainRequest binding failed with exception");
+  }
+}
+
+NAN_SETTER(NConnectionBuilder::setRetainRequest) {
+  try {
+    CheckedUnwrap(info.Holder())->_retainRequest = to<bool>(value);
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.setRetainRequest binding failed with exception");
+  }
+}
+
+NAN_GETTER(NConnectionBuilder::getSpillThreshold) {
+  try {
+    auto obj = CheckedUnwrap(info.Holder());
+    info.GetReturnValue().Set(Nan::New<v8::Number>(static_cast<double>(obj->_spillThreshold)));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.getSpillThreshold binding failed with exception");
+  }
+}
+
+NAN_SETTER(NConnectionBuilder::setSpillThreshold) {
+  try {
+    auto threshold = Nan::To<double>(value).FromJust();
+    if (!(threshold >= 0)) {
+      Nan::ThrowRangeError("spillThreshold must be a non-negative number");
+      return;
+    }
+    CheckedUnwrap(info.Holder())->_spillThreshold = static_cast<uint64_t>(threshold);
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.setSpillThreshold binding failed with exception");
+  }
+}
+
+NAN_GETTER(NConnectionBuilder::getPoolSize) {
+  try {
+    auto obj = CheckedUnwrap(info.Holder());
+    info.GetReturnValue().Set(Nan::New<v8::Uint32>(obj->_poolSize));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.getPoolSize binding failed with exception");
+  }
+}
+
+NAN_SETTER(NConnectionBuilder::setPoolSize) {
+  try {
+    auto size = to<uint32_t>(value);
+    if (size < 1) {
+      Nan::ThrowRangeError("poolSize must be at least 1");
+      return;
+    }
+    CheckedUnwrap(info.Holder())->_poolSize = size;
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.setPoolSize binding failed with exception");
+  }
+}
+
+NAN_GETTER(NConnectionBuilder::getHedgePercentile) {
+  try {
+    auto obj = CheckedUnwrap(info.Holder());
+    info.GetReturnValue().Set(Nan::New<v8::Number>(obj->_hedgePercentile));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.getHedgePercentile binding failed with exception");
+  }
+}
+
+NAN_SETTER(NConnectionBuilder::setHedgePercentile) {
+  try {
+    auto percentile = Nan::To<double>(value).FromJust();
+    if (!(percentile >= 0 && percentile < 100)) {
+      Nan::ThrowRangeError("hedgePercentile must be a number from 0 to 100 (exclusive)");
+      return;
+    }
+    CheckedUnwrap(info.Holder())->_hedgePercentile = percentile;
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.setHedgePercentile binding failed with exception");
+  }
+}
+
+NAN_GETTER(NConnectionBuilder::getHosts) {
+  try {
+    auto obj = CheckedUnwrap(info.Holder());
+    auto result = Nan::New<v8::Array>(static_cast<int>(obj->_hosts.size()));
+    uint32_t index = 0;
+    for (auto const& host : obj->_hosts) {
+      result->Set(index++, toString(host));
+    }
+    info.GetReturnValue().Set(result);
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.getHosts binding failed with exception");
+  }
+}
+
+NAN_SETTER(NConnectionBuilder::setHosts) {
+  try {
+    if (!value->IsArray()) {
+      Nan::ThrowTypeError("hosts must be an array of URLs");
+      return;
+    }
+    auto array = v8::Local<v8::Array>::Cast(value);
+    std::vector<std::string> hosts;
+    for (uint32_t i = 0; i < array->Length(); ++i) {
+      auto host = array->Get(i);
+      if (!host->IsString()) {
+        Nan::ThrowTypeError("hosts must be an array of URLs");
+        return;
+      }
+      hosts.push_back(to<std::string>(host));
+    }
+    CheckedUnwrap(info.Holder())->_hosts = std::move(hosts);
+  } catch(std::exception const& e) {
+    Nan::ThrowError("ConnectionBuilder.setHosts binding failed with exception");
+  }
+}
+
 }}}
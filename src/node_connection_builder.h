@@ -26,6 +26,8 @@
 #define FUERTE_NODE_CONNECTION_BUILDER_H
 
 #include <iostream>
+#include <string>
+#include <vector>
 #include "node_upstream.h"
 #include "object_wrap.h"
 
@@ -34,7 +36,7 @@ namespace arangodb { namespace fuerte { namespace js {
 // NConnectionBuilder is a node wrapper around the fuerte ConnectionBuilder class.
 class NConnectionBuilder : public ObjectWrap<NConnectionBuilder, fu::ConnectionBuilder, std::unique_ptr<fu::ConnectionBuilder>> {
   friend class NConnection;
-  NConnectionBuilder(): ObjectWrap() {}
+  NConnectionBuilder(): ObjectWrap(), _resolveCollectionNames(false), _retainRequest(true), _spillThreshold(0), _poolSize(1), _hedgePercentile(0) {}
 
 public:
   static NAN_MODULE_INIT(Init) {
@@ -48,6 +50,12 @@ public:
     Nan::SetAccessor(itpl, toString("nativeHost"), NConnectionBuilder::getHost, NConnectionBuilder::setHost);
     Nan::SetAccessor(itpl, toString("userName"), NConnectionBuilder::getUserName, NConnectionBuilder::setUserName);
     Nan::SetAccessor(itpl, toString("password"), NConnectionBuilder::getPassword, NConnectionBuilder::setPassword);
+    Nan::SetAccessor(itpl, toString("resolveCollectionNames"), NConnectionBuilder::getResolveCollectionNames, NConnectionBuilder::setResolveCollectionNames);
+    Nan::SetAccessor(itpl, toString("retainRequest"), NConnectionBuilder::getRetainRequest, NConnectionBuilder::setRetainRequest);
+    Nan::SetAccessor(itpl, toString("spillThreshold"), NConnectionBuilder::getSpillThreshold, NConnectionBuilder::setSpillThreshold);
+    Nan::SetAccessor(itpl, toString("poolSize"), NConnectionBuilder::getPoolSize, NConnectionBuilder::setPoolSize);
+    Nan::SetAccessor(itpl, toString("nativeHosts"), NConnectionBuilder::getHosts, NConnectionBuilder::setHosts);
+    Nan::SetAccessor(itpl, toString("hedgePercentile"), NConnectionBuilder::getHedgePercentile, NConnectionBuilder::setHedgePercentile);
 
     initClass("ConnectionBuilder", target, tpl);
   }
@@ -68,6 +76,38 @@ public:
   static NAN_GETTER(getPassword);
   // Set authentication password
   static NAN_SETTER(setPassword);
+  // Get resolving of collection names in custom _id values
+  static NAN_GETTER(getResolveCollectionNames);
+  // Set resolving of collection names in custom _id values
+  static NAN_SETTER(setResolveCollectionNames);
+  // Get whether responses keep a reference to their request
+  static NAN_GETTER(getRetainRequest);
+  // Set whether responses keep a reference to their request
+  static NAN_SETTER(setRetainRequest);
+  // Get the payload size above which responses are moved to a temp file (0 = never)
+  static NAN_GETTER(getSpillThreshold);
+  // Set the payload size above which responses are moved to a temp file (0 = never)
+  static NAN_SETTER(setSpillThreshold);
+  // Get the maximum number of fuerte connections of a connection
+  static NAN_GETTER(getPoolSize);
+  // Set the maximum number of fuerte connections of a connection
+  static NAN_SETTER(setPoolSize);
+  // Get the URLs of all servers (if there is more than one).
+  static NAN_GETTER(getHosts);
+  // Set the URLs of all servers, requests are routed between them.
+  static NAN_SETTER(setHosts);
+  // Get the latency percentile after which idempotent requests are hedged (0 = never)
+  static NAN_GETTER(getHedgePercentile);
+  // Set the latency percentile after which idempotent requests are hedged (0 = never)
+  static NAN_SETTER(setHedgePercentile);
+
+private:
+  bool _resolveCollectionNames;
+  bool _retainRequest;
+  uint64_t _spillThreshold;
+  uint32_t _poolSize;
+  std::vector<std::string> _hosts;
+  double _hedgePercentile;
 };
 
 }}}
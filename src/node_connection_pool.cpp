@@ -0,0 +1,417 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "node_connection_pool.h"
+
+namespace arangodb { namespace fuerte { namespace js {
+
+std::chrono::seconds const ConnectionPool::IdleTimeout(30);
+// consecutive failures after which an endpoint is ejected
+std::size_t const ConnectionPool::MaxFailures = 3;
+// samples needed before latencyPercentile reports anything
+std::size_t const ConnectionPool::MinSamples = 16;
+// routes for which response times are sampled
+std::size_t const ConnectionPool::MaxRoutes = 64;
+// probe delays of ejected endpoints (doubled on every failed probe)
+static std::chrono::milliseconds const MinBackoff(500);
+static std::chrono::milliseconds const MaxBackoff(30000);
+// weight of a new latency sample
+static double const LatencyWeight = 0.2;
+
+// isFailure returns true if a request failed because of its endpoint:
+// a transport error or a 503 response. Other errors, such as a client side
+// timeout of a slow request, say nothing about the health of the endpoint.
+static bool isFailure(unsigned err, fu::Response const* res) {
+  if (err != 0) {
+    switch (static_cast<fu::ErrorCondition>(err)) {
+      case fu::ErrorCondition::CouldNotConnect:
+      case fu::ErrorCondition::ConnectionError:
+      case fu::ErrorCondition::VstReadError:
+      case fu::ErrorCondition::VstWriteError:
+        return true;
+      default:
+        return false;
+    }
+  }
+  if (res == nullptr) {
+    return true;
+  }
+  // unavailable (e.g. shutting down or not yet ready)
+  return res->header.responseCode && res->header.responseCode.get() == 503;
+}
+
+// settle is called when a copy of a hedged request (if any) has finished.
+// It returns true if its result is to be passed on: the first success, or
+// the failure of the last outstanding copy when none has succeeded.
+static bool settle(ConnectionPool::Hedge* hedge, bool failed) {
+  if (hedge == nullptr) {
+    return true;
+  }
+  auto const left = --hedge->outstanding;
+  if (failed && left > 0) {
+    // another copy may still succeed
+    return false;
+  }
+  return !hedge->settled.exchange(true);
+}
+
+// routeOf returns the key under which the response times of request are
+// sampled: its verb and the first two segments of its path, such as
+// "GET /_api/document". Quick lookups and slow queries get percentiles of
+// their own, without a key per document.
+static std::string routeOf(fu::Request const& request) {
+  std::string route;
+  if (request.header.restVerb) {
+    route = fu::to_string(request.header.restVerb.get());
+  }
+  route.push_back(' ');
+  if (request.header.path) {
+    auto const& path = request.header.path.get();
+    std::size_t end = 0;
+    for (int segments = 0; segments < 2 && end != std::string::npos; ++segments) {
+      end = path.find('/', end + 1);
+    }
+    route.append(path, 0, end);
+  }
+  return route;
+}
+
+ConnectionPool::ConnectionPool(std::vector<fu::ConnectionBuilder> const& builders,
+                               EventLoopService& loop, std::size_t maxSize)
+  : _loop(loop), _maxSize(maxSize > 0 ? maxSize : 1), _next(0) {
+  auto now = Clock::now();
+  bool connected = false;
+  for (auto const& builder : builders) {
+    std::unique_ptr<Endpoint> endpoint(new Endpoint());
+    endpoint->builder = builder;
+    endpoint->outstanding = 0;
+    endpoint->latency = 0;
+    endpoint->failures = 0;
+    endpoint->ejected = false;
+    endpoint->probing = false;
+    endpoint->backoff = MinBackoff;
+    if (connect(*endpoint, now)) {
+      connected = true;
+    } else {
+      eject(*endpoint, now);
+    }
+    _endpoints.push_back(std::move(endpoint));
+  }
+  if (!connected) {
+    throw std::runtime_error("cannot connect to any endpoint");
+  }
+}
+
+std::shared_ptr<ConnectionPool::Member> ConnectionPool::connect(Endpoint& endpoint, Clock::time_point now) {
+  auto conn = endpoint.builder.connect(_loop);
+  if (conn == nullptr) {
+    return nullptr;
+  }
+  auto member = std::make_shared<Member>();
+  member->connection = std::move(conn);
+  member->outstanding = 0;
+  member->idleSince = now;
+  endpoint.members.push_back(member);
+  return member;
+}
+
+ConnectionPool::Endpoint* ConnectionPool::selectEndpoint(Endpoint const* exclude) {
+  Endpoint* best = nullptr;
+  double bestScore = std::numeric_limits<double>::max();
+  auto const n = _endpoints.size();
+  // start at a different endpoint every time, so ties are spread evenly
+  auto const start = _next++ % n;
+  for (std::size_t i = 0; i < n; ++i) {
+    auto& endpoint = *_endpoints[(start + i) % n];
+    if (endpoint.ejected || &endpoint == exclude) {
+      continue;
+    }
+    // 1ms keeps the outstanding count relevant while latency is unknown
+    double score = (endpoint.latency + 1.0) * static_cast<double>(endpoint.outstanding + 1);
+    if (score < bestScore) {
+      best = &endpoint;
+      bestScore = score;
+    }
+  }
+  if (best == nullptr && exclude == nullptr) {
+    // all endpoints are ejected, use the one that is retried first
+    for (auto const& endpoint : _endpoints) {
+      if (best == nullptr || endpoint->retryAt < best->retryAt) {
+        best = endpoint.get();
+      }
+    }
+  }
+  return best;
+}
+
+std::shared_ptr<ConnectionPool::Member> ConnectionPool::selectMember(Endpoint& endpoint, Clock::time_point now,
+                                                                    Member const* exclude) {
+  // close connections that have been idle too long (always keep one)
+  for (std::size_t i = endpoint.members.size(); i > 1; --i) {
+    auto const& member = endpoint.members[i - 1];
+    if (member->outstanding == 0 && now - member->idleSince > IdleTimeout) {
+      endpoint.members.erase(endpoint.members.begin() + (i - 1));
+    }
+  }
+  std::shared_ptr<Member> best;
+  for (auto const& member : endpoint.members) {
+    if (member.get() == exclude) {
+      continue;
+    }
+    if (!best || member->outstanding < best->outstanding) {
+      best = member;
+    }
+  }
+  if (!best || (best->outstanding > 0 && endpoint.members.size() < _maxSize)) {
+    // all connections are busy, open another one
+    auto member = connect(endpoint, now);
+    if (member) {
+      return member;
+    }
+  }
+  return best;
+}
+
+void ConnectionPool::eject(Endpoint& endpoint, Clock::time_point now) {
+  if (!endpoint.ejected) {
+    endpoint.ejected = true;
+    endpoint.backoff = MinBackoff;
+  }
+  endpoint.retryAt = now + endpoint.backoff;
+  // its connections may be broken, use fresh ones when it is back
+  endpoint.members.clear();
+}
+
+void ConnectionPool::probe(Clock::time_point now) {
+  for (auto const& ptr : _endpoints) {
+    auto& endpoint = *ptr;
+    if (!endpoint.ejected || endpoint.probing || now < endpoint.retryAt) {
+      continue;
+    }
+    auto conn = endpoint.builder.connect(_loop);
+    if (conn == nullptr) {
+      endpoint.backoff = std::min<Clock::duration>(endpoint.backoff * 2, MaxBackoff);
+      endpoint.retryAt = now + endpoint.backoff;
+      continue;
+    }
+    endpoint.probing = true;
+    auto req = std::unique_ptr<fu::Request>(new fu::Request());
+    req->header.restVerb = fu::RestVerb::Get;
+    req->header.path = std::string("/_api/version");
+    auto self = shared_from_this();
+    auto ep = &endpoint;
+    conn->sendRequest(std::move(req),
+        [self, ep, conn, now](unsigned err, std::unique_ptr<fu::Request>, std::unique_ptr<fu::Response> res) {
+      auto const done = Clock::now();
+      std::lock_guard<std::mutex> guard(self->_mutex);
+      ep->probing = false;
+      if (isFailure(err, res.get())) {
+        ep->backoff = std::min<Clock::duration>(ep->backoff * 2, MaxBackoff);
+        ep->retryAt = done + ep->backoff;
+        return;
+      }
+      // back in service, starting with the latency of the probe
+      ep->ejected = false;
+      ep->failures = 0;
+      ep->latency = std::chrono::duration<double, std::milli>(done - now).count();
+      auto member = std::make_shared<Member>();
+      member->connection = conn;
+      member->outstanding = 0;
+      member->idleSince = done;
+      ep->members.push_back(std::move(member));
+    });
+  }
+}
+
+void ConnectionPool::sendRequest(std::unique_ptr<fu::Request> request, PoolCallback callback,
+                                 std::shared_ptr<Hedge> hedge) {
+  if (!send(request, callback, hedge, nullptr, nullptr, true)) {
+    // no other copy has been sent yet
+    if (!hedge || !hedge->settled.exchange(true)) {
+      callback(static_cast<unsigned>(fu::ErrorCondition::CouldNotConnect), std::move(request), nullptr);
+    }
+  }
+}
+
+bool ConnectionPool::hedgeRequest(std::unique_ptr<fu::Request> request, PoolCallback callback,
+                                  std::shared_ptr<Hedge> const& hedge) {
+  Endpoint* endpoint;
+  std::shared_ptr<Member> member;
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+    endpoint = hedge->endpoint;
+    member = hedge->member;
+  }
+  if (hedge->settled.load() || !member) {
+    return false;
+  }
+  return send(request, callback, hedge, endpoint, member.get(), false);
+}
+
+bool ConnectionPool::send(std::unique_ptr<fu::Request>& request, PoolCallback const& callback,
+                          std::shared_ptr<Hedge> const& hedge, Endpoint* excludeEndpoint,
+                          Member const* excludeMember, bool retry) {
+  Endpoint* endpoint;
+  std::shared_ptr<Member> member;
+  auto const now = Clock::now();
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+    probe(now);
+    endpoint = selectEndpoint(excludeEndpoint);
+    if (endpoint == nullptr && excludeMember != nullptr && !excludeEndpoint->ejected) {
+      // the only healthy endpoint, use another one of its connections
+      endpoint = excludeEndpoint;
+    }
+    if (endpoint == nullptr) {
+      return false;
+    }
+    member = selectMember(*endpoint, now, excludeMember);
+    if (!member) {
+      if (endpoint->members.empty()) {
+        // not even a new connection could be opened
+        eject(*endpoint, now);
+      }
+      return false;
+    }
+    member->outstanding++;
+    endpoint->outstanding++;
+    if (hedge) {
+      hedge->outstanding++;
+      if (excludeMember == nullptr) {
+        hedge->endpoint = endpoint;
+        hedge->member = member;
+      }
+    }
+  }
+  auto self = shared_from_this();
+  auto route = routeOf(*request);
+  member->connection->sendRequest(std::move(request),
+      [self, endpoint, member, now, callback, hedge, route, retry](unsigned err, std::unique_ptr<fu::Request> req, std::unique_ptr<fu::Response> res) {
+    bool const failed = isFailure(err, res.get());
+    // the request never reached the server, retry it once elsewhere
+    bool const retried = retry && req && err == static_cast<unsigned>(fu::ErrorCondition::CouldNotConnect) &&
+      (!hedge || !hedge->settled.load()) &&
+      self->send(req, callback, hedge, endpoint, nullptr, false);
+    if (retried) {
+      self->finished(*endpoint, member, now, true, nullptr);
+      if (hedge) {
+        // the retry has taken the place of this copy
+        hedge->outstanding--;
+      }
+      return;
+    }
+    bool const pass = settle(hedge.get(), failed);
+    // a copy that finishes late must not skew the response times
+    self->finished(*endpoint, member, now, failed, pass ? &route : nullptr);
+    if (pass) {
+      callback(err, std::move(req), std::move(res));
+    }
+  });
+  return true;
+}
+
+void ConnectionPool::finished(Endpoint& endpoint, std::shared_ptr<Member> const& member,
+                              Clock::time_point started, bool failed, std::string const* route) {
+  auto const now = Clock::now();
+  std::lock_guard<std::mutex> guard(_mutex);
+  if (--member->outstanding == 0) {
+    member->idleSince = now;
+  }
+  endpoint.outstanding--;
+  if (failed) {
+    if (++endpoint.failures >= MaxFailures && !endpoint.ejected) {
+      eject(endpoint, now);
+    }
+    return;
+  }
+  endpoint.failures = 0;
+  double sample = std::chrono::duration<double, std::milli>(now - started).count();
+  if (route != nullptr) {
+    auto it = _samples.find(*route);
+    if (it == _samples.end() && _samples.size() < MaxRoutes) {
+      it = _samples.emplace(*route, Samples()).first;
+    }
+    if (it != _samples.end()) {
+      auto& samples = it->second;
+      samples.values[samples.count++ % samples.values.size()] = sample;
+    }
+  }
+  if (endpoint.latency == 0) {
+    endpoint.latency = sample;
+  } else {
+    endpoint.latency = (1 - LatencyWeight) * endpoint.latency + LatencyWeight * sample;
+  }
+}
+
+std::size_t ConnectionPool::requestsLeft() const {
+  std::lock_guard<std::mutex> guard(_mutex);
+  std::size_t result = 0;
+  for (auto const& endpoint : _endpoints) {
+    result += endpoint->outstanding;
+  }
+  return result;
+}
+
+std::size_t ConnectionPool::size() const {
+  std::lock_guard<std::mutex> guard(_mutex);
+  std::size_t result = 0;
+  for (auto const& endpoint : _endpoints) {
+    result += endpoint->members.size();
+  }
+  return result;
+}
+
+std::size_t ConnectionPool::healthyEndpoints() const {
+  std::lock_guard<std::mutex> guard(_mutex);
+  std::size_t result = 0;
+  for (auto const& endpoint : _endpoints) {
+    if (!endpoint->ejected) {
+      result++;
+    }
+  }
+  return result;
+}
+
+double ConnectionPool::latencyPercentile(fu::Request const& request, double percentile) const {
+  auto const route = routeOf(request);
+  std::vector<double> samples;
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto it = _samples.find(route);
+    if (it == _samples.end() || it->second.count < MinSamples) {
+      return 0;
+    }
+    auto const& values = it->second.values;
+    auto const n = std::min(it->second.count, values.size());
+    samples.assign(values.begin(), values.begin() + n);
+  }
+  auto index = static_cast<std::size_t>(percentile / 100.0 * static_cast<double>(samples.size()));
+  index = std::min(index, samples.size() - 1);
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index];
+}
+
+}}}
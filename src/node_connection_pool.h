@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#ifndef FUERTE_NODE_CONNECTION_POOL_H
+#define FUERTE_NODE_CONNECTION_POOL_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fuerte/loop.h>
+
+#include "node_upstream.h"
+
+namespace arangodb { namespace fuerte { namespace js {
+
+using PoolCallback = std::function<void(unsigned, std::unique_ptr<fu::Request>, std::unique_ptr<fu::Response>)>;
+
+// ConnectionPool sends requests over fuerte connections to one or more
+// endpoints (servers). Each request goes to the endpoint with the lowest
+// (EWMA) latency weighted by its outstanding requests, and there to the
+// connection with the fewest outstanding requests.
+// Per endpoint, up to maxSize connections are opened when all existing
+// ones are busy; they are closed again after they have been idle for a
+// while. Endpoints that fail repeatedly are ejected. There is no background
+// task: when a request is sent, ejected endpoints whose backoff has passed
+// are probed, until they respond again.
+// A request that fails because its endpoint could not be connected to never
+// reached the server, it is retried once on another endpoint.
+class ConnectionPool : public std::enable_shared_from_this<ConnectionPool> {
+  struct Member;
+  struct Endpoint;
+public:
+  // Hedge is shared by the copies of a hedged request.
+  struct Hedge {
+    std::atomic<bool> settled{false};         // a copy has passed on its result
+    std::atomic<std::size_t> outstanding{0};  // copies sent that have not finished
+    // connection of the first copy, hedged copies avoid it (guarded by the pool mutex)
+    Endpoint* endpoint = nullptr;
+    std::shared_ptr<Member> member;
+  };
+
+  // Opens the first connection of every endpoint. Throws if no endpoint
+  // could be connected.
+  ConnectionPool(std::vector<fu::ConnectionBuilder> const& builders,
+                 EventLoopService& loop, std::size_t maxSize);
+
+  // Send a request on the least busy connection of the best endpoint.
+  // Requests that share `hedge` are copies of each other (hedged requests):
+  // only the first to succeed (or the last to fail, if none succeeds) is
+  // sampled and passed to its callback, the responses of the others are
+  // dropped.
+  void sendRequest(std::unique_ptr<fu::Request> request, PoolCallback callback,
+                   std::shared_ptr<Hedge> hedge = nullptr);
+  // Send a copy of a request that was sent with hedge, on another connection
+  // than the first copy (on another endpoint, if there is a healthy one).
+  // Returns false, without sending, if there is no such connection or the
+  // request has already settled.
+  bool hedgeRequest(std::unique_ptr<fu::Request> request, PoolCallback callback,
+                    std::shared_ptr<Hedge> const& hedge);
+  // Returns the number of unfinished requests on all connections.
+  std::size_t requestsLeft() const;
+  // Returns the number of open connections.
+  std::size_t size() const;
+  // Returns the number of endpoints that are not ejected.
+  std::size_t healthyEndpoints() const;
+  // Returns the given percentile (0-100) of the recent response times in ms
+  // of requests to the same route (verb and leading path segments) as
+  // request, or 0 while there are too few samples.
+  double latencyPercentile(fu::Request const& request, double percentile) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Member {
+    std::shared_ptr<fu::Connection> connection;
+    std::size_t outstanding;
+    Clock::time_point idleSince;
+  };
+
+  // response times (ms) of the most recent successful requests of a route
+  struct Samples {
+    std::array<double, 256> values;
+    std::size_t count = 0;
+  };
+
+  struct Endpoint {
+    fu::ConnectionBuilder builder;
+    std::vector<std::shared_ptr<Member>> members;
+    std::size_t outstanding;
+    double latency;            // EWMA of the response time in ms
+    std::size_t failures;      // consecutive failures
+    bool ejected;
+    bool probing;
+    Clock::duration backoff;
+    Clock::time_point retryAt; // time of the next probe (if ejected)
+  };
+
+  // Sends request on the best endpoint other than excludeEndpoint and there
+  // on a connection other than excludeMember. Only if excludeMember is set,
+  // another connection of excludeEndpoint may be used when it is the only
+  // healthy endpoint. A CouldNotConnect failure is retried once elsewhere if
+  // retry is set. Returns false, leaving request untouched, if no connection
+  // was available.
+  bool send(std::unique_ptr<fu::Request>& request, PoolCallback const& callback,
+            std::shared_ptr<Hedge> const& hedge, Endpoint* excludeEndpoint,
+            Member const* excludeMember, bool retry);
+  // Returns the endpoint to send the next request to, other than exclude
+  // (called with _mutex held). Returns null only if exclude is the only
+  // endpoint that is not ejected.
+  Endpoint* selectEndpoint(Endpoint const* exclude = nullptr);
+  // Returns the member of endpoint, other than exclude, to send the next request on
+  // (called with _mutex held). Returns null if there is none and none could be opened.
+  std::shared_ptr<Member> selectMember(Endpoint& endpoint, Clock::time_point now,
+                                       Member const* exclude = nullptr);
+  // Opens a connection to endpoint (called with _mutex held).
+  std::shared_ptr<Member> connect(Endpoint& endpoint, Clock::time_point now);
+  // Ejects endpoint until its next probe (called with _mutex held).
+  void eject(Endpoint& endpoint, Clock::time_point now);
+  // Probes ejected endpoints that are due (called with _mutex held).
+  void probe(Clock::time_point now);
+  // Called (on an IO thread) when a request on member of endpoint has finished.
+  // Its response time is sampled for route, unless route is null.
+  void finished(Endpoint& endpoint, std::shared_ptr<Member> const& member,
+                Clock::time_point started, bool failed, std::string const* route);
+
+  static std::chrono::seconds const IdleTimeout;
+  static std::size_t const MaxFailures;
+  static std::size_t const MinSamples;
+  static std::size_t const MaxRoutes;
+
+  EventLoopService& _loop;
+  std::size_t const _maxSize;
+  mutable std::mutex _mutex;
+  std::vector<std::unique_ptr<Endpoint>> _endpoints;
+  std::size_t _next;
+  std::unordered_map<std::string, Samples> _samples;
+};
+
+}}}
+#endif
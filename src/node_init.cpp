@@ -22,11 +22,15 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "node_init.h"
+#include "node_buffer_pool.h"
+#include "node_builder.h"
 #include "node_connection.h"
 #include "node_connection_builder.h"
+#include "node_projection.h"
 #include "node_request.h"
 #include "node_response.h"
 #include "node_vpack.h"
+#include "node_vpack_file.h"
 
 #include <iostream>
 #include <fuerte/loop.h>
@@ -37,6 +41,10 @@ namespace arangodb { namespace fuerte { namespace js {
 NAN_MODULE_INIT(InitAll) {
   FUERTE_LOG_NODE << "About to init classes" << std::endl;
   InitVPack(target);
+  InitBufferPool(target);
+  NProjection::Init(target);
+  NBuilder::Init(target);
+  NVPackFile::Init(target);
   NConnectionBuilder::Init(target);
   NConnection::Init(target);
   NRequest::Init(target);
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "node_mapped_file.h"
+
+namespace arangodb { namespace fuerte { namespace js {
+
+static std::runtime_error systemError(std::string const& what, std::string const& name) {
+  return std::runtime_error(what + " '" + name + "': " + std::strerror(errno));
+}
+
+MappedFile::MappedFile(std::string const& path, uint64_t offset, uint64_t length)
+  : _mapping(nullptr), _mappingSize(0), _data(nullptr), _size(0) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw systemError("cannot open", path);
+  }
+  try {
+    map(fd, offset, length, path);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  // the mapping stays valid after closing the descriptor
+  ::close(fd);
+}
+
+MappedFile::MappedFile(int fd, uint64_t offset, uint64_t length)
+  : _mapping(nullptr), _mappingSize(0), _data(nullptr), _size(0) {
+  map(fd, offset, length, "fd " + std::to_string(fd));
+}
+
+MappedFile::~MappedFile() {
+  if (_mapping != nullptr) {
+    ::munmap(_mapping, _mappingSize);
+  }
+}
+
+void MappedFile::map(int fd, uint64_t offset, uint64_t length, std::string const& name) {
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    throw systemError("cannot stat", name);
+  }
+  if (!S_ISREG(st.st_mode)) {
+    // pipes, sockets and devices have no (meaningful) size to map
+    throw std::runtime_error("not a regular file '" + name + "'");
+  }
+  auto fileSize = static_cast<uint64_t>(st.st_size);
+  if (offset > fileSize) {
+    throw std::runtime_error("offset beyond end of file '" + name + "'");
+  }
+  if (length == 0 || length > fileSize - offset) {
+    length = fileSize - offset;
+  }
+  _size = static_cast<std::size_t>(length);
+  if (_size == 0) {
+    // mmap does not accept empty mappings
+    return;
+  }
+  // mappings must start at a page boundary
+  auto pageSize = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+  auto start = offset - (offset % pageSize);
+  _mappingSize = static_cast<std::size_t>(length + (offset - start));
+  void* mapping = ::mmap(nullptr, _mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                         fd, static_cast<off_t>(start));
+  if (mapping == MAP_FAILED) {
+    throw systemError("cannot map", name);
+  }
+  _mapping = mapping;
+  _data = static_cast<uint8_t*>(mapping) + (offset - start);
+}
+
+}}}
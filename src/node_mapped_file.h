@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#ifndef FUERTE_NODE_MAPPED_FILE_H
+#define FUERTE_NODE_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace arangodb { namespace fuerte { namespace js {
+
+// MappedFile is a private (copy-on-write) memory mapping of an entire file.
+// Writes to the mapped memory never reach the file.
+class MappedFile {
+public:
+  // Map `length` bytes (0 means up to the end) of the file at the given path,
+  // starting at `offset`. Throws on failure.
+  explicit MappedFile(std::string const& path, uint64_t offset = 0, uint64_t length = 0);
+  // Map `length` bytes (0 means up to the end) of an open file descriptor,
+  // starting at `offset`. The descriptor is not closed. Throws on failure,
+  // including when the descriptor is not a regular file (e.g. a pipe).
+  MappedFile(int fd, uint64_t offset, uint64_t length);
+  ~MappedFile();
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+
+  uint8_t* data() const { return _data; }
+  std::size_t size() const { return _size; }
+
+private:
+  void map(int fd, uint64_t offset, uint64_t length, std::string const& name);
+
+  void* _mapping;
+  std::size_t _mappingSize;
+  uint8_t* _data;
+  std::size_t _size;
+};
+
+}}}
+#endif
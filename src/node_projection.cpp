@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+
+#include <memory>
+#include <stdexcept>
+
+#include "node_projection.h"
+
+namespace arangodb { namespace fuerte { namespace js {
+
+// compile all paths in the given array into root
+static void addPaths(ProjectionNode& root, v8::Local<v8::Value> value) {
+  if (!value->IsArray()) {
+    throw std::invalid_argument("expected an array of attribute paths");
+  }
+  auto paths = v8::Local<v8::Array>::Cast(value);
+  uint32_t const n = paths->Length();
+  for (uint32_t i = 0; i < n; ++i) {
+    auto path = paths->Get(i);
+    if (!path->IsString()) {
+      throw std::invalid_argument("attribute path is not a string");
+    }
+    TRI_AddProjectionPath(root, to<std::string>(path));
+  }
+}
+
+NAN_METHOD(NProjection::New) {
+  try {
+    if (info.IsConstructCall()) {
+      auto obj = new NProjection();
+      obj->Wrap(info.This());
+      if (info.Length() > 0) {
+        addPaths(*obj->cppClass(), info[0]);
+      }
+      info.GetReturnValue().Set(info.This());
+    } else {
+      int argc = info.Length() > 0 ? 1 : 0;
+      v8::Local<v8::Value> argv[1] = {info[0]};
+      info.GetReturnValue().Set(NProjection::NewInstance(argc, argv).ToLocalChecked());
+    }
+  } catch(std::exception const& e) {
+    std::string msg = std::string("Projection.New binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+ProjectionNode const* toProjection(v8::Local<v8::Value> value,
+                                   std::unique_ptr<ProjectionNode>& compiled) {
+  if (NProjection::HasInstance(value)) {
+    return unwrap<NProjection>(value)->cppClass();
+  }
+  compiled.reset(new ProjectionNode());
+  addPaths(*compiled, value);
+  return compiled.get();
+}
+
+ProjectionNode const* decodeProjection(Nan::FunctionCallbackInfo<v8::Value> const& info,
+                                       std::unique_ptr<ProjectionNode>& compiled) {
+  if (info.Length() > 1 && info[1]->IsObject()) {
+    auto paths = Nan::Get(info[1]->ToObject(), Nan::New("paths").ToLocalChecked()).ToLocalChecked();
+    if (!paths->IsUndefined()) {
+      return toProjection(paths, compiled);
+    }
+  }
+  return nullptr;
+}
+
+}}}
@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#ifndef FUERTE_NODE_PROJECTION_H
+#define FUERTE_NODE_PROJECTION_H
+
+#include "node_upstream.h"
+#include "node_vpack.h"
+#include "object_wrap.h"
+
+namespace arangodb { namespace fuerte { namespace js {
+
+// NProjection is a node wrapper around a compiled set of attribute paths.
+// It can be passed to vpackDecode & Response.project in place of an array
+// of paths, to avoid compiling the same paths over and over again.
+class NProjection : public ObjectWrap<NProjection, ProjectionNode, std::unique_ptr<ProjectionNode>> {
+  NProjection(): ObjectWrap() {}
+
+public:
+  static NAN_MODULE_INIT(Init) {
+    auto tpl = Nan::New<v8::FunctionTemplate>(New);
+    tpl->SetClassName(Nan::New("Projection").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    initClass("Projection", target, tpl);
+  }
+
+  // Node constructor, takes an array of attribute paths ("a.b.c").
+  static NAN_METHOD(New);
+};
+
+// toProjection returns the projection described by value, which is either
+// a Projection object or an array of attribute paths. In the latter case
+// the paths are compiled into `compiled`, which must outlive the result.
+ProjectionNode const* toProjection(v8::Local<v8::Value> value,
+                                   std::unique_ptr<ProjectionNode>& compiled);
+
+// decodeProjection returns the optional projection of the decode functions,
+// given as second argument: (x, {paths: [...] | Projection}). Returns
+// nullptr if there is none.
+ProjectionNode const* decodeProjection(Nan::FunctionCallbackInfo<v8::Value> const& info,
+                                       std::unique_ptr<ProjectionNode>& compiled);
+
+}}}
+#endif
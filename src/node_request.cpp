@@ -21,14 +21,89 @@
 /// @author Ewout Prangsma
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "node_buffer_pool.h"
+#include "node_builder.h"
 #include "node_request.h"
 #include "node_vpack.h"
 
 namespace arangodb { namespace fuerte { namespace js {
 
+static std::runtime_error systemError(std::string const& what, std::string const& name) {
+  return std::runtime_error(what + " '" + name + "': " + std::strerror(errno));
+}
+
+static void readRange(int fd, FileBody const& body, std::string const& name, fu::Request& req) {
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    throw systemError("cannot stat", name);
+  }
+  if (!S_ISREG(st.st_mode)) {
+    // pipes, sockets and devices have no (meaningful) size
+    throw std::runtime_error("not a regular file '" + name + "'");
+  }
+  auto fileSize = static_cast<uint64_t>(st.st_size);
+  if (body.offset > fileSize) {
+    throw std::runtime_error("offset beyond end of file '" + name + "'");
+  }
+  auto length = body.length;
+  if (length == 0 || length > fileSize - body.offset) {
+    length = fileSize - body.offset;
+  }
+  if (length > MaxFileBodySize) {
+    throw std::runtime_error("file body of " + std::to_string(length) +
+                             " bytes exceeds the maximum of " +
+                             std::to_string(MaxFileBodySize) + " bytes '" + name + "'");
+  }
+  // pread leaves the file position of a caller-owned descriptor untouched
+  uint8_t chunk[64 * 1024];
+  auto offset = body.offset;
+  while (length > 0) {
+    auto want = static_cast<std::size_t>(std::min<uint64_t>(length, sizeof(chunk)));
+    auto got = ::pread(fd, chunk, want, static_cast<off_t>(offset));
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw systemError("cannot read", name);
+    }
+    if (got == 0) {
+      throw std::runtime_error("unexpected end of file '" + name + "'");
+    }
+    req.addBinary(chunk, static_cast<std::size_t>(got));
+    offset += static_cast<uint64_t>(got);
+    length -= static_cast<uint64_t>(got);
+  }
+}
+
+void readFileBody(FileBody const& body, fu::Request& req) {
+  if (!body.path.empty()) {
+    int fd = ::open(body.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      throw systemError("cannot open", body.path);
+    }
+    try {
+      readRange(fd, body, body.path, req);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    ::close(fd);
+    return;
+  }
+  readRange(body.fd, body, "fd " + std::to_string(body.fd), req);
+}
+
 // NRequest
 NAN_METHOD(NRequest::New) {
   if (info.IsConstructCall()) {
@@ -60,17 +135,26 @@ NAN_METHOD(NRequest::addBody) { // Buffer | Object
       // Add slice 
       self(info)->addVPack(slice);
       info.GetReturnValue().Set(info.This());
+    } else if (NBuilder::HasInstance(info[0])) {
+      // Got Builder
+      auto builder = unwrap<NBuilder>(info[0])->cppClass();
+      if (!builder->isClosed()) {
+        Nan::ThrowError("Request.addBody: builder is not closed");
+        return;
+      }
+      self(info)->addVPack(builder->slice());
+      info.GetReturnValue().Set(info.This());
     } else {
       // Got any other V8 value
-      VPackBuilder builder;
-      auto tri = TRI_V8ToVPack(info.GetIsolate(), builder, info[0], false);
+      PooledBuilder builder;
+      auto tri = TRI_V8ToVPack(info.GetIsolate(), *builder, info[0], false);
       if (tri != TRI_ERROR_NO_ERROR) {
         std::string errorMessage = std::string("Request.addBody: Error while encoding: TRI_ERROR(") + std::to_string(tri) + ")";
         Nan::ThrowError(errorMessage.c_str());
         return;
       }
 
-      self(info)->addVPack(builder.slice());
+      self(info)->addVPack(builder->slice());
       info.GetReturnValue().Set(info.This());
     }
   } catch(std::exception const& e) {
@@ -127,6 +211,75 @@ NAN_METHOD(NRequest::addBinary) {
   }
 }
 
+NAN_METHOD(NRequest::addJsonBody) {
+  try {
+    if (info.Length() != 1 ) {
+      Nan::ThrowTypeError("Wrong number of Arguments");
+      return;
+    }
+    auto obj = CheckedUnwrap(info.Holder());
+    if (obj->_jsonBody || obj->_fileBody) {
+      Nan::ThrowError("Request.addJsonBody: request already has a JSON or file body");
+      return;
+    }
+    if (::node::Buffer::HasInstance(info[0])) {
+      auto data = ::node::Buffer::Data(info[0]);
+      auto length = ::node::Buffer::Length(info[0]);
+      obj->_jsonBody = std::make_shared<std::string>(data, length);
+    } else if (info[0]->IsString()) {
+      obj->_jsonBody = std::make_shared<std::string>(to<std::string>(info[0]));
+    } else {
+      Nan::ThrowTypeError("Expected string or Buffer argument");
+      return;
+    }
+    info.GetReturnValue().Set(info.This());
+  } catch(std::exception const& e) {
+    Nan::ThrowError("Request.addJsonBody binding failed with exception");
+  }
+}
+
+NAN_METHOD(NRequest::addFile) {
+  try {
+    if (info.Length() < 1 || info.Length() > 3) {
+      Nan::ThrowTypeError("Wrong number of Arguments");
+      return;
+    }
+    auto obj = CheckedUnwrap(info.Holder());
+    if (obj->_jsonBody || obj->_fileBody) {
+      Nan::ThrowError("Request.addFile: request already has a JSON or file body");
+      return;
+    }
+    auto body = std::make_shared<FileBody>();
+    body->fd = -1;
+    body->offset = 0;
+    body->length = 0;
+    if (info[0]->IsString()) {
+      body->path = to<std::string>(info[0]);
+    } else if (info[0]->IsInt32() && to<int32_t>(info[0]) >= 0) {
+      body->fd = to<int32_t>(info[0]);
+    } else {
+      Nan::ThrowTypeError("Expected path or file descriptor argument");
+      return;
+    }
+    for (int i = 1; i < info.Length(); ++i) {
+      if (!info[i]->IsNumber() || Nan::To<double>(info[i]).FromJust() < 0) {
+        Nan::ThrowTypeError("Expected non-negative offset and length arguments");
+        return;
+      }
+    }
+    if (info.Length() > 1) {
+      body->offset = static_cast<uint64_t>(Nan::To<double>(info[1]).FromJust());
+    }
+    if (info.Length() > 2) {
+      body->length = static_cast<uint64_t>(Nan::To<double>(info[2]).FromJust());
+    }
+    obj->_fileBody = std::move(body);
+    info.GetReturnValue().Set(info.This());
+  } catch(std::exception const& e) {
+    Nan::ThrowError("Request.addFile binding failed with exception");
+  }
+}
+
 NAN_SETTER(NRequest::setPath) {
   try {
     self(info)->header.path = to<std::string>(value);
@@ -234,6 +387,54 @@ NAN_GETTER(NRequest::getAcceptType) {
   }
 }
 
+NAN_SETTER(NRequest::setRenderJson) {
+  try {
+    CheckedUnwrap(info.Holder())->_renderJson = Nan::To<bool>(value).FromJust();
+  } catch(std::exception const& e) {
+    Nan::ThrowError("Request.setRenderJson binding failed with exception");
+  }
+}
+
+NAN_GETTER(NRequest::getRenderJson) {
+  try {
+    info.GetReturnValue().Set(Nan::New<v8::Boolean>(CheckedUnwrap(info.Holder())->_renderJson));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("Request.getRenderJson binding failed with exception");
+  }
+}
+
+NAN_SETTER(NRequest::setIdempotent) {
+  try {
+    CheckedUnwrap(info.Holder())->_idempotent = Nan::To<bool>(value).FromJust();
+  } catch(std::exception const& e) {
+    Nan::ThrowError("Request.setIdempotent binding failed with exception");
+  }
+}
+
+NAN_GETTER(NRequest::getIdempotent) {
+  try {
+    info.GetReturnValue().Set(Nan::New<v8::Boolean>(CheckedUnwrap(info.Holder())->_idempotent));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("Request.getIdempotent binding failed with exception");
+  }
+}
+
+NAN_SETTER(NRequest::setParseJson) {
+  try {
+    CheckedUnwrap(info.Holder())->_parseJson = Nan::To<bool>(value).FromJust();
+  } catch(std::exception const& e) {
+    Nan::ThrowError("Request.setParseJson binding failed with exception");
+  }
+}
+
+NAN_GETTER(NRequest::getParseJson) {
+  try {
+    info.GetReturnValue().Set(Nan::New<v8::Boolean>(CheckedUnwrap(info.Holder())->_parseJson));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("Request.getParseJson binding failed with exception");
+  }
+}
+
 NAN_METHOD(NRequest::addQueryParameter) {
   try {
     if (info.Length() != 2 ) {
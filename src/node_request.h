@@ -30,6 +30,23 @@
 
 namespace arangodb { namespace fuerte { namespace js {
 
+// FileBody describes a file (range) that is added to a request payload.
+struct FileBody {
+  std::string path; // empty if fd is used
+  int fd;
+  uint64_t offset;
+  uint64_t length;  // 0 means up to the end of the file
+};
+
+// fuerte keeps the whole payload in memory, so file bodies are limited (1GiB).
+constexpr uint64_t MaxFileBodySize = uint64_t(1) << 30;
+
+// Read the file (range) described by body and append it to the payload of req.
+// The file is read in chunks straight into the payload, without mapping it.
+// Throws when the file cannot be read, is not a regular file or is larger
+// than MaxFileBodySize.
+void readFileBody(FileBody const& body, fu::Request& req);
+
 // NRequest is a Node wrapper around the fuerte Request class.
 class NRequest : public ObjectWrap<NRequest, fu::Request, std::unique_ptr<fu::Request>> {
     friend class PendingRequest;
@@ -46,6 +63,8 @@ public:
     Nan::SetPrototypeMethod(tpl, "addBody", NRequest::addBody);
     Nan::SetPrototypeMethod(tpl, "addSlice", NRequest::addSlice);
     Nan::SetPrototypeMethod(tpl, "addBinary", NRequest::addBinary);
+    Nan::SetPrototypeMethod(tpl, "addJsonBody", NRequest::addJsonBody);
+    Nan::SetPrototypeMethod(tpl, "addFile", NRequest::addFile);
     Nan::SetPrototypeMethod(tpl, "addQueryParameter", NRequest::addQueryParameter);
     Nan::SetPrototypeMethod(tpl, "addHeader", NRequest::addHeader);
 
@@ -55,18 +74,27 @@ public:
     Nan::SetAccessor(itpl, toString("method"), NRequest::getMethod, NRequest::setMethod);
     Nan::SetAccessor(itpl, toString("contentType"), NRequest::getContentType, NRequest::setContentType);
     Nan::SetAccessor(itpl, toString("acceptType"), NRequest::getAcceptType, NRequest::setAcceptType);
+    Nan::SetAccessor(itpl, toString("renderJson"), NRequest::getRenderJson, NRequest::setRenderJson);
+    Nan::SetAccessor(itpl, toString("idempotent"), NRequest::getIdempotent, NRequest::setIdempotent);
+    Nan::SetAccessor(itpl, toString("parseJson"), NRequest::getParseJson, NRequest::setParseJson);
 
     initClass("Request", target, tpl);
   }
 
   // Node Request constructor 
   static NAN_METHOD(New);
-  // Add a buffer or object payload.
+  // Add a buffer, Builder or object payload.
   static NAN_METHOD(addBody);
   // Add a velocypack Slice payload (in node Buffer).
   static NAN_METHOD(addSlice);
   // Add a binary payload (in a node Buffer).
   static NAN_METHOD(addBinary);
+  // Add a JSON text payload (string or Buffer), converted to velocypack
+  // off the main thread when the request is sent.
+  static NAN_METHOD(addJsonBody);
+  // Add (a range of) a file (path or descriptor) as binary payload, read
+  // off the main thread when the request is sent.
+  static NAN_METHOD(addFile);
   
   // Get the local path of the request 
   static NAN_GETTER(getPath);
@@ -88,11 +116,35 @@ public:
   static NAN_GETTER(getAcceptType);
   // Set the Accept-type of the request (which content type to accept in response)
   static NAN_SETTER(setAcceptType);
+  // Get whether velocypack responses are rendered as JSON text off the main thread
+  static NAN_GETTER(getRenderJson);
+  // Set whether velocypack responses are rendered as JSON text off the main thread
+  static NAN_SETTER(setRenderJson);
+  // Get whether the request may be sent twice (e.g. a read-only query)
+  static NAN_GETTER(getIdempotent);
+  // Set whether the request may be sent twice (e.g. a read-only query)
+  static NAN_SETTER(setIdempotent);
+  // Get whether JSON responses are parsed into velocypack off the main thread
+  static NAN_GETTER(getParseJson);
+  // Set whether JSON responses are parsed into velocypack off the main thread
+  static NAN_SETTER(setParseJson);
 
   // Add a query parameter to the request
   static NAN_METHOD(addQueryParameter);
   // Add a header key/value pair to the request
   static NAN_METHOD(addHeader);
+
+private:
+  // JSON text added by addJsonBody (shared with pending requests)
+  std::shared_ptr<std::string const> _jsonBody;
+  // File added by addFile (shared with pending requests)
+  std::shared_ptr<FileBody const> _fileBody;
+  // render velocypack responses as JSON text on the IO thread (see Response.jsonBuffer)
+  bool _renderJson = false;
+  // the request may be hedged (sent twice) even though it is not a GET
+  bool _idempotent = false;
+  // parse JSON responses into velocypack on the IO thread (see Response.body)
+  bool _parseJson = false;
 };
 
 }}}
@@ -21,17 +21,181 @@
 /// @author Ewout Prangsma
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <strings.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#include <velocypack/Exception.h>
+#include <velocypack/Parser.h>
 
 #include "node_response.h"
+#include "node_projection.h"
 #include "node_vpack.h"
 
 namespace arangodb { namespace fuerte { namespace js {
 
+// decodeSlices converts a list of slices using the given decode function.
+// A single slice is returned as is, multiple slices are returned as an array
+// and an empty list results in undefined.
+template <typename F>
+static v8::Local<v8::Value> decodeSlices(std::vector<VPackSlice> const& slices, F const& decode) {
+  if (slices.size() == 0) {
+    // Empty response
+    return Nan::Undefined();
+  } else if (slices.size() == 1) {
+    // Single response 
+    return decode(slices[0]);
+  }
+  // Multiple responses
+  v8::Local<v8::Array> array = Nan::New<v8::Array>(static_cast<int>(slices.size()));
+  uint32_t index = 0;
+  for (auto const& slice : slices) {
+    array->Set(index++, decode(slice));
+  }
+  return array;
+}
+
+// at most this many distinct header names are cached
+static std::size_t const MaxHeaderNames = 256;
+
+// headerName returns the header name as internalized string. Names are
+// cached, so header objects share their property name strings.
+static v8::Local<v8::String> headerName(v8::Isolate* isolate, std::string const& name) {
+  // one cache per isolate (isolates do not share threads)
+  static thread_local std::unordered_map<std::string, Nan::Persistent<v8::String>> names;
+  auto it = names.find(name);
+  if (it != names.end()) {
+    return Nan::New(it->second);
+  }
+  auto str = v8::String::NewFromUtf8(isolate, name.data(), v8::NewStringType::kInternalized,
+                                     static_cast<int>(name.size())).ToLocalChecked();
+  if (names.size() < MaxHeaderNames) {
+    names[name].Reset(str);
+  }
+  return str;
+}
+
 // NResponse
 const char* response_is_null("C++ Response is nullptr - maybe you did not receive a response - please check the error code!");
 
+std::shared_ptr<VPackBuilder> NResponse::parseJson(boost::asio::const_buffer const& payload) {
+  auto size = boost::asio::buffer_size(payload);
+  if (size == 0) {
+    return nullptr;
+  }
+  VPackParser parser;
+  parser.parse(boost::asio::buffer_cast<uint8_t const*>(payload), size);
+  return parser.steal();
+}
+
+std::shared_ptr<MappedFile> NResponse::spillPayload(fu::Response& res) {
+  auto payload = res.payload();
+  auto data = boost::asio::buffer_cast<char const*>(payload);
+  auto size = boost::asio::buffer_size(payload);
+  // create an anonymous temp file
+  char const* dir = getenv("TMPDIR");
+  std::string name = std::string(dir != nullptr ? dir : "/tmp") + "/fuerte-response-XXXXXX";
+  int fd = ::mkstemp(&name[0]);
+  if (fd < 0) {
+    throw std::runtime_error("cannot create temp file: " + std::string(std::strerror(errno)));
+  }
+  ::unlink(name.c_str());
+  std::shared_ptr<MappedFile> file;
+  try {
+    std::size_t written = 0;
+    while (written < size) {
+      auto n = ::write(fd, data + written, size - written);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::runtime_error("cannot write temp file: " + std::string(std::strerror(errno)));
+      }
+      written += static_cast<std::size_t>(n);
+    }
+    file = std::make_shared<MappedFile>(fd, 0, 0);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+  // drop the heap copy
+  res.setPayload(VPBuffer(), 0);
+  return file;
+}
+
+boost::asio::const_buffer NResponse::payload() const {
+  if (_spilled) {
+    return boost::asio::const_buffer(_spilled->data(), _spilled->size());
+  }
+  return cppPtr()->payload();
+}
+
+std::vector<VPackSlice> NResponse::slices() const {
+  if (!_spilled) {
+    return cppPtr()->slices();
+  }
+  // the slices are stored back to back
+  std::vector<VPackSlice> result;
+  auto data = _spilled->data();
+  auto const size = _spilled->size();
+  std::size_t pos = 0;
+  while (pos < size) {
+    VPackSlice slice(data + pos);
+    auto sliceSize = static_cast<std::size_t>(slice.byteSize());
+    if (sliceSize == 0 || sliceSize > size - pos) {
+      throw std::runtime_error("truncated slice in response payload");
+    }
+    result.push_back(slice);
+    pos += sliceSize;
+  }
+  return result;
+}
+
+std::shared_ptr<void> NResponse::payloadOwner() const {
+  if (_spilled) {
+    return _spilled;
+  }
+  return cppPtr();
+}
+
+std::vector<VPackSlice> NResponse::bodySlices() {
+  auto res = cppClass();
+  if (res->isContentTypeVPack()) {
+    return slices();
+  } else if (res->isContentTypeJSON()) {
+    if (!_parsedJson) {
+      setParsedJson(parseJson(payload()));
+    }
+    if (!_parsedJson) {
+      return {};
+    }
+    return { _parsedJson->slice() };
+  }
+  throw std::runtime_error("unsupported content type: " + res->contentTypeString());
+}
+
+void NResponse::setResponse(std::shared_ptr<fu::Response> res) {
+  auto size = res ? boost::asio::buffer_size(res->payload()) : 0;
+  setCppClass(accountExternal(std::move(res), size));
+}
+
+void NResponse::setJson(std::shared_ptr<std::string> json) {
+  auto size = json ? json->size() : 0;
+  _json = accountExternal(std::move(json), size);
+}
+
+void NResponse::setParsedJson(std::shared_ptr<VPackBuilder> builder) {
+  auto size = builder ? static_cast<std::size_t>(builder->buffer()->capacity()) : 0;
+  _parsedJson = accountExternal(std::move(builder), size);
+}
+
 NAN_METHOD(NResponse::New) {
   if (info.IsConstructCall()) {
     auto obj = new NResponse();
@@ -42,65 +206,59 @@ NAN_METHOD(NResponse::New) {
  }
 }
 
+v8::Local<v8::Value> NResponse::cached(const Nan::PropertyCallbackInfo<v8::Value>& info,
+                                       CachedField field, Builder build) {
+  auto holder = info.Holder();
+  if (CheckedUnwrap(holder) == nullptr) {
+    return Nan::Undefined();
+  }
+  // fields start out undefined (as does the body of an empty response,
+  // which is cheap to build again)
+  auto value = holder->GetInternalField(field);
+  if (value->IsUndefined()) {
+    value = build(info);
+    holder->SetInternalField(field, value);
+  }
+  return value;
+}
+
+void NResponse::setRequest(v8::Local<v8::Object> response, v8::Local<v8::Object> request) {
+  response->SetInternalField(RequestField, request);
+}
+
 // Return the entire response payload as a decoded V8 object/array/value.
 NAN_GETTER(NResponse::getBody) {
   try {
-    auto key = toString("__body");
-    if (Nan::Has(info.This(), key).FromJust()) {
-      auto result = Nan::Get(info.This(), key);
-      info.GetReturnValue().Set(result.ToLocalChecked());
-    } else {
-      auto result = buildV8Body(info);
-      Nan::Set(info.This(), key, result);
-      info.GetReturnValue().Set(result);
-    }
+    info.GetReturnValue().Set(cached(info, BodyField, buildV8Body));
   } catch (std::exception const& e) {
     Nan::ThrowError("Reponse.body binding failed with exception");
   }
 }
 
 v8::Local<v8::Value> NResponse::buildV8Body(const Nan::PropertyCallbackInfo<v8::Value>& info) {
-  auto res = self(info);
+  auto obj = CheckedUnwrap(info.Holder());
+  auto res = obj->cppClass();
   if (res) {
     // Check content type 
-    if (res->isContentTypeVPack()) {
-      auto& slices = res->slices();
-      if (slices.size() == 0) {
-        // Empty response
-        return Nan::Undefined();
-      } else if (slices.size() == 1) {
-        // Single response 
-        auto isolate = info.GetIsolate();
-        auto options = &::arangodb::velocypack::Options::Defaults;
-        auto value = TRI_VPackToV8(isolate, slices[0], options);
-        return value;
-      } else {
-        // Multiple responses
-        v8::Local<v8::Array> array;
-        std::size_t index = 0;
-        auto isolate = info.GetIsolate();
-        auto options = &::arangodb::velocypack::Options::Defaults;
-        for (auto const& slice : slices) {
-          auto value = TRI_VPackToV8(isolate, slice, options);
-          array->Set(index++, value);
-        }
-        return array;
+    if (res->isContentTypeVPack() || res->isContentTypeJSON()) {
+      // JSON is decoded from its velocypack form as well
+      auto isolate = info.GetIsolate();
+      auto options = obj->vpackOptions();
+      std::vector<VPackSlice> slices;
+      try {
+        slices = obj->bodySlices();
+      } catch (VPackException const&) {
+        throw std::runtime_error("Response.body failed to parse json payload");
       }
+      return decodeSlices(slices, [&](VPackSlice const& slice) {
+        return TRI_VPackToV8(isolate, slice, options);
+      });
     } else {
-      auto payload = res->payloadAsString();
-      auto payloadAsString = Nan::New(payload).ToLocalChecked();
-      if (res->isContentTypeJSON()) {
-        // Parse json
-        Nan::JSON NanJSON;
-        auto result = NanJSON.Parse(payloadAsString);
-        if (!result.IsEmpty()) {
-          return result.ToLocalChecked();
-        } else {
-          throw std::runtime_error("Response.body failed to parse json payload");
-        }
-      } else if (res->isContentTypeText()) {
+      if (res->isContentTypeText()) {
         // Plain text content
-        return payloadAsString;
+        auto payload = obj->payload();
+        return Nan::New(boost::asio::buffer_cast<char const*>(payload),
+                        static_cast<int>(boost::asio::buffer_size(payload))).ToLocalChecked();
       } else {
         // Unknown content type
         auto msg = "Response.body unknown content type: " + res->contentTypeString();
@@ -112,31 +270,132 @@ v8::Local<v8::Value> NResponse::buildV8Body(const Nan::PropertyCallbackInfo<v8::
   }
 }
 
-NAN_GETTER(NResponse::getSlices) {
+// Return the payload decoded with only the given attribute paths materialized.
+NAN_METHOD(NResponse::project) {
   try {
-    auto key = toString("__slices");
-    if (Nan::Has(info.This(), key).FromJust()) {
-      auto result = Nan::Get(info.This(), key);
-      info.GetReturnValue().Set(result.ToLocalChecked());
-    } else {
-      auto result = buildV8Slices(info);
-      Nan::Set(info.This(), key, result);
-      info.GetReturnValue().Set(result);
+    if (info.Length() != 1) {
+      Nan::ThrowTypeError("Wrong number of Arguments");
+      return;
+    }
+    auto obj = CheckedUnwrap(info.Holder());
+    if (!obj->cppClass()) {
+      Nan::ThrowError(response_is_null);
+      return;
+    }
+    std::unique_ptr<ProjectionNode> compiled;
+    auto projection = toProjection(info[0], compiled);
+    auto isolate = info.GetIsolate();
+    auto options = obj->vpackOptions();
+    info.GetReturnValue().Set(decodeSlices(obj->bodySlices(), [&](VPackSlice const& slice) {
+      return TRI_VPackToV8Projected(isolate, slice, *projection, options);
+    }));
+  } catch (std::exception const& e) {
+    std::string msg = std::string("Response.project binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+// Return the payload (array of objects) decoded into columns.
+NAN_METHOD(NResponse::columns) {
+  try {
+    if (info.Length() != 1) {
+      Nan::ThrowTypeError("Wrong number of Arguments");
+      return;
+    }
+    auto obj = CheckedUnwrap(info.Holder());
+    if (!obj->cppClass()) {
+      Nan::ThrowError(response_is_null);
+      return;
+    }
+    auto columns = TRI_V8ToColumnSpecs(info[0]);
+    auto isolate = info.GetIsolate();
+    auto options = obj->vpackOptions();
+    info.GetReturnValue().Set(decodeSlices(obj->bodySlices(), [&](VPackSlice const& slice) {
+      return TRI_VPackToV8Columns(isolate, slice, columns, options);
+    }));
+  } catch (std::exception const& e) {
+    std::string msg = std::string("Response.columns binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+// Return the payload as JSON text in a buffer.
+NAN_METHOD(NResponse::jsonBuffer) {
+  try {
+    auto obj = CheckedUnwrap(info.Holder());
+    auto res = obj->cppClass();
+    if (!res) {
+      Nan::ThrowError(response_is_null);
+      return;
+    }
+    if (res->isContentTypeJSON()) {
+      // Already JSON
+      auto payload = obj->payload();
+      info.GetReturnValue().Set(externalBuffer(boost::asio::buffer_cast<char const*>(payload),
+                                               boost::asio::buffer_size(payload), obj->payloadOwner()));
+      return;
+    }
+    if (!res->isContentTypeVPack()) {
+      auto msg = "Response.jsonBuffer unsupported content type: " + res->contentTypeString();
+      Nan::ThrowError(msg.c_str());
+      return;
+    }
+    auto slices = obj->slices();
+    if (slices.empty()) {
+      info.GetReturnValue().Set(Nan::Undefined());
+      return;
+    }
+    if (!obj->_json) {
+      // Not rendered on the IO thread (renderJson not set), do it now
+      auto json = std::make_shared<std::string>();
+      TRI_VPackToJson(slices, obj->vpackOptions(), *json);
+      obj->setJson(std::move(json));
     }
+    info.GetReturnValue().Set(externalBuffer(obj->_json->data(), obj->_json->size(), obj->_json));
+  } catch (std::exception const& e) {
+    std::string msg = std::string("Response.jsonBuffer binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+// Release the native response data.
+NAN_METHOD(NResponse::release) {
+  try {
+    auto obj = CheckedUnwrap(info.Holder());
+    obj->setCppClass(nullptr);
+    obj->_spilled.reset();
+    obj->_json.reset();
+    obj->_parsedJson.reset();
+    // these buffers view the response data
+    auto holder = info.Holder();
+    holder->SetInternalField(PayloadField, Nan::Undefined());
+    holder->SetInternalField(SlicesField, Nan::Undefined());
+  } catch (std::exception const& e) {
+    std::string msg = std::string("Response.release binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_GETTER(NResponse::getSlices) {
+  try {
+    info.GetReturnValue().Set(cached(info, SlicesField, buildV8Slices));
   } catch (std::exception const& e) {
     Nan::ThrowError("Reponse.getSlices binding failed with exception");
   }
 }
 
 v8::Local<v8::Value> NResponse::buildV8Slices(const Nan::PropertyCallbackInfo<v8::Value>& info) {
-  auto res = self(info);
+  auto obj = CheckedUnwrap(info.Holder());
+  auto res = obj->cppClass();
   if (res) {
-    v8::Local<v8::Array> array = Nan::New<v8::Array>();
     if (res->isContentTypeVPack()) {
-      std::size_t index = 0;
-      for (auto const& slice : res->slices()) {
-        auto buf = Nan::CopyBuffer(slice.startAs<char>(), slice.byteSize());
-        //array->Set(index++, buf.ToLocalChecked());
+      // The buffers view the response storage
+      auto slices = obj->slices();
+      auto owner = obj->payloadOwner();
+      v8::Local<v8::Array> array = Nan::New<v8::Array>(static_cast<int>(slices.size()));
+      uint32_t index = 0;
+      for (auto const& slice : slices) {
+        array->Set(index++, externalBuffer(slice.startAs<char>(), slice.byteSize(), owner));
       }
       return array;
     } else {
@@ -150,33 +409,38 @@ v8::Local<v8::Value> NResponse::buildV8Slices(const Nan::PropertyCallbackInfo<v8
 
 NAN_GETTER(NResponse::getPayload) {
   try {
-    auto key = toString("__payload");
-    if (Nan::Has(info.This(), key).FromJust()) {
-      auto result = Nan::Get(info.This(), key);
-      info.GetReturnValue().Set(result.ToLocalChecked());
-    } else {
-      auto result = buildV8Payload(info);
-      Nan::Set(info.This(), key, result);
-      info.GetReturnValue().Set(result);
-    }
+    info.GetReturnValue().Set(cached(info, PayloadField, buildV8Payload));
   } catch (std::exception const& e) {
     Nan::ThrowError("Reponse.getPayload binding failed with exception");
   }
 }
 
 v8::Local<v8::Value> NResponse::buildV8Payload(const Nan::PropertyCallbackInfo<v8::Value>& info) {
-  auto res = self(info);
+  auto obj = CheckedUnwrap(info.Holder());
+  auto res = obj->cppClass();
   if (res) {
-    auto payload = res->payload();
+    // The buffer views the response storage
+    auto payload = obj->payload();
     auto payloadSize = boost::asio::buffer_size(payload);
     auto payloadData = boost::asio::buffer_cast<const char*>(payload);
-    auto buf = Nan::CopyBuffer(payloadData, payloadSize);
-    return buf.ToLocalChecked();
+    return externalBuffer(payloadData, payloadSize, obj->payloadOwner());
   } else {
     throw std::runtime_error(response_is_null);
   }
 }
 
+NAN_GETTER(NResponse::getRequest) {
+  try {
+    if (CheckedUnwrap(info.Holder()) == nullptr) {
+      return;
+    }
+    // undefined if the request was not retained
+    info.GetReturnValue().Set(info.Holder()->GetInternalField(RequestField));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("Response.request binding failed with exception");
+  }
+}
+
 NAN_GETTER(NResponse::getResponseCode) {
   try {
     auto res = self(info);
@@ -198,30 +462,22 @@ NAN_GETTER(NResponse::getResponseCode) {
 
 NAN_GETTER(NResponse::getHeader) {
   try {
-    auto key = toString("__header");
-    if (Nan::Has(info.This(), key).FromJust()) {
-      auto header = Nan::Get(info.This(), key);
-      info.GetReturnValue().Set(header.ToLocalChecked());
-    } else {
-      auto header = buildV8Header(info);
-      Nan::Set(info.This(), key, header);
-      info.GetReturnValue().Set(header);
-    }
+    info.GetReturnValue().Set(cached(info, HeaderField, buildV8Header));
   } catch (std::exception const& e) {
     Nan::ThrowError("Reponse.header binding failed with exception");
   }
 }
 
-v8::Local<v8::Object> NResponse::buildV8Header(const Nan::PropertyCallbackInfo<v8::Value>& info) {
+v8::Local<v8::Value> NResponse::buildV8Header(const Nan::PropertyCallbackInfo<v8::Value>& info) {
   auto res = self(info);
   if (res) {
     auto& header = res->header;
     auto result = Nan::New<v8::Object>();
     if (header.meta) {
-      auto meta = header.meta.value();
+      auto const& meta = header.meta.value();
       auto isolate = info.GetIsolate()->GetCurrentContext();
       for (auto& pair : meta) {
-        auto key = Nan::New(pair.first).ToLocalChecked();
+        auto key = headerName(info.GetIsolate(), pair.first);
         auto value = Nan::New(pair.second).ToLocalChecked();
         auto done = result->Set(isolate, key, value);
         if (!done.FromJust()) {
@@ -235,6 +491,38 @@ v8::Local<v8::Object> NResponse::buildV8Header(const Nan::PropertyCallbackInfo<v
   }
 }
 
+NAN_METHOD(NResponse::lookupHeader) {
+  try {
+    if (info.Length() != 1) {
+      Nan::ThrowTypeError("Wrong number of Arguments");
+      return;
+    }
+    auto res = self(info);
+    if (!res) {
+      Nan::ThrowError(response_is_null);
+      return;
+    }
+    auto& header = res->header;
+    if (header.meta) {
+      auto const& meta = header.meta.value();
+      auto name = to<std::string>(info[0]);
+      auto it = meta.find(name);
+      if (it == meta.end()) {
+        it = std::find_if(meta.begin(), meta.end(), [&name](auto const& pair) {
+          return pair.first.size() == name.size() && ::strncasecmp(pair.first.data(), name.data(), name.size()) == 0;
+        });
+      }
+      if (it != meta.end()) {
+        info.GetReturnValue().Set(Nan::New(it->second).ToLocalChecked());
+        return;
+      }
+    }
+    info.GetReturnValue().Set(Nan::Undefined());
+  } catch (std::exception const& e) {
+    std::string msg = std::string("Response.getHeader binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
 
 NAN_GETTER(NResponse::getContentType) {
   try {
@@ -25,22 +25,31 @@
 #ifndef FUERTE_NODE_RESPONSE_H
 #define FUERTE_NODE_RESPONSE_H
 
+#include "node_mapped_file.h"
 #include "node_upstream.h"
+#include "node_vpack.h"
 #include "object_wrap.h"
 
 namespace arangodb { namespace fuerte { namespace js {
 
 // NResponse is a node wrapper around the fuerte Response class.
-class NResponse : public ObjectWrap<NResponse, fu::Response, std::unique_ptr<fu::Response>> {
+class NResponse : public ObjectWrap<NResponse, fu::Response, std::shared_ptr<fu::Response>> {
     friend class PendingRequest;
     NResponse(): ObjectWrap() {}
-    NResponse(std::unique_ptr<fu::Response> x): ObjectWrap(std::move(x)) {}
+    NResponse(std::shared_ptr<fu::Response> x): ObjectWrap(std::move(x)) {}
 
 public:
   static NAN_MODULE_INIT(Init) {
     auto tpl = Nan::New<v8::FunctionTemplate>(New);
     tpl->SetClassName(Nan::New("Response").ToLocalChecked());
-    tpl->InstanceTemplate()->SetInternalFieldCount(1); //should be equal to the number of data members
+    // the wrapper plus the cached values (see CachedField)
+    tpl->InstanceTemplate()->SetInternalFieldCount(FieldCount);
+
+    Nan::SetPrototypeMethod(tpl, "project", NResponse::project);
+    Nan::SetPrototypeMethod(tpl, "columns", NResponse::columns);
+    Nan::SetPrototypeMethod(tpl, "jsonBuffer", NResponse::jsonBuffer);
+    Nan::SetPrototypeMethod(tpl, "getHeader", NResponse::lookupHeader);
+    Nan::SetPrototypeMethod(tpl, "release", NResponse::release);
 
     auto itpl = tpl->InstanceTemplate();
     Nan::SetAccessor(itpl, toString("contentType"), NResponse::getContentType);
@@ -49,6 +58,7 @@ public:
     Nan::SetAccessor(itpl, toString("body"), NResponse::getBody);
     Nan::SetAccessor(itpl, toString("slices"), NResponse::getSlices);
     Nan::SetAccessor(itpl, toString("payload"), NResponse::getPayload);
+    Nan::SetAccessor(itpl, toString("request"), NResponse::getRequest);
 
     initClass("Response", target, tpl);
   }
@@ -60,19 +70,96 @@ public:
   // responseCode returns the (HTTP) response code from the request
   static NAN_GETTER(getResponseCode);
   // header returns header meta data of this response
-  static v8::Local<v8::Object> buildV8Header(const Nan::PropertyCallbackInfo<v8::Value>& info);
+  static v8::Local<v8::Value> buildV8Header(const Nan::PropertyCallbackInfo<v8::Value>& info);
   static NAN_GETTER(getHeader);
+  // Return the value of a single header (name is matched case-insensitively),
+  // without building the header object.
+  static NAN_METHOD(lookupHeader);
   // Return the entire response payload as a decoded V8 object/array/value.
   static v8::Local<v8::Value> buildV8Body(const Nan::PropertyCallbackInfo<v8::Value>& info);
   static NAN_GETTER(getBody);
-  // Return the entire response payload in a buffer.
+  // Return the response payload decoded with only the given attribute
+  // paths (array of "a.b.c" strings or a Projection) materialized.
+  static NAN_METHOD(project);
+  // Return the response payload (an array of objects or a cursor result)
+  // decoded into one typed array / array per requested column.
+  static NAN_METHOD(columns);
+  // Return the response payload as JSON text in a buffer, without decoding
+  // it into JS values. Velocypack payloads are rendered on the IO thread if
+  // the request had renderJson set, otherwise when called.
+  static NAN_METHOD(jsonBuffer);
+  // Release the native response data now, instead of when the response is
+  // garbage collected. Only values that were already decoded stay available.
+  static NAN_METHOD(release);
+  // Return the entire response payload in a buffer (that views the response,
+  // which is kept alive until the buffer is garbage collected).
   static v8::Local<v8::Value> buildV8Payload(const Nan::PropertyCallbackInfo<v8::Value>& info);
   static NAN_GETTER(getPayload);
-  // Return an array containing all slices in the response payload, each as buffer.
+  // Return an array containing all slices in the response payload, each as buffer
+  // that views the response.
   // If the response does not have a velocypack content type, undefined
   // is returned.
   static v8::Local<v8::Value> buildV8Slices(const Nan::PropertyCallbackInfo<v8::Value>& info);
   static NAN_GETTER(getSlices);
+  // Return the request of this response (undefined if the connection
+  // does not retain requests).
+  static NAN_GETTER(getRequest);
+
+  // Parse a JSON payload into velocypack (returns nullptr for an empty payload).
+  static std::shared_ptr<VPackBuilder> parseJson(boost::asio::const_buffer const& payload);
+  // Move the payload of res into a memory mapped, unlinked temp file.
+  // The payload has already been received into memory, spilling only
+  // releases it early; it does not bound peak memory use.
+  static std::shared_ptr<MappedFile> spillPayload(fu::Response& res);
+
+  // Returns the payload (from the temp file, if it was spilled).
+  boost::asio::const_buffer payload() const;
+  // Returns the velocypack slices of the payload.
+  std::vector<VPackSlice> slices() const;
+  // Returns the owner of the payload memory.
+  std::shared_ptr<void> payloadOwner() const;
+
+  // Returns the velocypack slices of the body. JSON payloads are parsed
+  // into velocypack once (usually already done on the IO thread).
+  std::vector<VPackSlice> bodySlices();
+
+  // Options used to decode velocypack payloads of this response.
+  VPackOptions const* vpackOptions() const {
+    if (_collectionNames) {
+      return _collectionNames->options();
+    }
+    return TRI_DecodeOptions();
+  }
+
+private:
+  // Internal fields of the response object after the wrapper (field 0).
+  // They hold the values built by the getters and the retained request.
+  // Unlike persistent handles in the wrapper, the garbage collector traces
+  // them, so a cycle through the response (e.g. req.res = res) can be
+  // collected. All responses have the same fields, so they share one map.
+  enum CachedField { BodyField = 1, HeaderField, PayloadField, SlicesField, RequestField, FieldCount };
+
+  using Builder = v8::Local<v8::Value> (*)(const Nan::PropertyCallbackInfo<v8::Value>&);
+  // Returns the value of a getter, built on first access and then stored in
+  // an internal field of the response object.
+  static v8::Local<v8::Value> cached(const Nan::PropertyCallbackInfo<v8::Value>& info,
+                                     CachedField field, Builder build);
+  // Store the request of a response.
+  static void setRequest(v8::Local<v8::Object> response, v8::Local<v8::Object> request);
+
+  // Setters for the native data, which report its size to V8.
+  void setResponse(std::shared_ptr<fu::Response> res);
+  void setJson(std::shared_ptr<std::string> json);
+  void setParsedJson(std::shared_ptr<VPackBuilder> builder);
+
+  // Resolver of the connection, if it resolves collection names in _id values.
+  std::shared_ptr<CollectionNameResolver> _collectionNames;
+  // JSON text of the velocypack payload, rendered on the IO thread.
+  std::shared_ptr<std::string> _json;
+  // Payload moved out of the response because of its size (if any).
+  std::shared_ptr<MappedFile> _spilled;
+  // Velocypack of the JSON payload.
+  std::shared_ptr<VPackBuilder> _parsedJson;
 };
 
 }}}
@@ -30,6 +30,9 @@
 #include <node.h>
 #include <nan.h>
 
+#include <cstdint>
+#include <memory>
+
 #include <fuerte/fuerte.h>
 
 namespace fu = ::arangodb::fuerte;
@@ -111,6 +114,48 @@ ClassType* unwrap(v8::Local<v8::Value> const& info){
   return Nan::ObjectWrap::Unwrap<ClassType>(info->ToObject());
 }
 
+// externalBuffer returns a Buffer that views `length` bytes at `data`
+// without copying them. `owner` (the owner of that memory) is kept alive
+// until the Buffer is garbage collected.
+template <typename T>
+v8::Local<v8::Object> externalBuffer(char const* data, std::size_t length,
+                                     std::shared_ptr<T> const& owner) {
+  if (length == 0) {
+    return Nan::NewBuffer(0).ToLocalChecked();
+  }
+  auto hint = new std::shared_ptr<T>(owner);
+  auto buf = Nan::NewBuffer(const_cast<char*>(data), static_cast<uint32_t>(length),
+                            [](char*, void* hint) {
+    delete static_cast<std::shared_ptr<T>*>(hint);
+  }, hint);
+  return buf.ToLocalChecked();
+}
+
+// adjustExternalMemory reports a change of the externally allocated memory
+// to V8. Unlike Nan::AdjustExternalMemory it takes a 64bit amount, so that
+// sizes of 2GiB and more are not truncated.
+inline int64_t adjustExternalMemory(int64_t change) {
+  return v8::Isolate::GetCurrent()->AdjustAmountOfExternalAllocatedMemory(change);
+}
+
+// accountExternal reports `size` bytes held by `object` to V8, so they
+// count towards its garbage collection heuristics, until the returned
+// pointer (and all its copies) are gone. Must be used on the main thread
+// only, including the release of the last copy.
+template <typename T>
+std::shared_ptr<T> accountExternal(std::shared_ptr<T> object, std::size_t size) {
+  if (!object || size == 0) {
+    return object;
+  }
+  auto const amount = static_cast<int64_t>(size);
+  adjustExternalMemory(amount);
+  auto ptr = object.get();
+  return std::shared_ptr<T>(ptr, [object, amount](T*) mutable {
+    object.reset();
+    adjustExternalMemory(-amount);
+  });
+}
+
 template <typename ClassType, typename T>
 ClassType* _unwrapSelf(Nan::FunctionCallbackInfo<T> const& info){
   return Nan::ObjectWrap::Unwrap<ClassType>(info.Holder());
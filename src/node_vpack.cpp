@@ -26,15 +26,21 @@
 #include <nan.h>
 
 #include <cmath>
+#include <limits>
+#include <velocypack/AttributeTranslator.h>
 #include <velocypack/Buffer.h>
 #include <velocypack/Builder.h>
 #include <velocypack/Dumper.h>
 #include <velocypack/Iterator.h>
 #include <velocypack/Options.h>
+#include <velocypack/Sink.h>
 #include <velocypack/Slice.h>
 #include <velocypack/velocypack-aliases.h>
 
 #include "node_vpack.h"
+#include "node_buffer_pool.h"
+#include "node_projection.h"
+#include "node_upstream.h"
 
 #include <iostream>
 
@@ -64,6 +70,11 @@ static inline T ReadNumber(uint8_t const* source, uint32_t length) {
   return value;
 }
 
+/// @brief reads the collection id of a custom _id value
+static inline uint64_t CustomCollectionId(VPackSlice const& value) {
+  return ReadNumber<uint64_t>(value.begin() + 1, sizeof(uint64_t));
+}
+
 // a default custom type handler that prevents throwing exceptions when
 // custom types are encountered during Slice.toJson() and family
 struct DefaultCustomTypeHandler final : public VPackCustomTypeHandler {
@@ -78,15 +89,179 @@ struct DefaultCustomTypeHandler final : public VPackCustomTypeHandler {
 
   std::string stringify(VPackSlice const& value, VPackSlice const& base) {
     if (value.isCustom()) {
-      uint64_t cid = ReadNumber<uint64_t>(value.begin() + 1, sizeof(uint64_t));
-      if (base.isObject() && base.get("_key").isString()) {
-        return std::to_string(cid) + "/" + base.get("_key").copyString();
+      uint64_t cid = CustomCollectionId(value);
+      VPackSlice key = base.isObject() ? TRI_VPackGet(base, "_key", TRI_DecodeOptions()) : VPackSlice();
+      if (key.isString()) {
+        return std::to_string(cid) + "/" + key.copyString();
       }
     }
     return "cannot handle custom _id value";
   }
 };
 
+CollectionNameResolver::CollectionNameResolver()
+    : _options(*TRI_DecodeOptions()) {
+  _options.customTypeHandler = this;
+}
+
+void CollectionNameResolver::dump(VPackSlice const& value, VPackDumper* dumper,
+                                  VPackSlice const& base) {
+  dumper->appendString(toString(value, &_options, base));
+}
+
+std::string CollectionNameResolver::toString(VPackSlice const& value,
+                                             VPackOptions const* options,
+                                             VPackSlice const& base) {
+  if (value.isCustom()) {
+    uint64_t cid = CustomCollectionId(value);
+    VPackSlice key = base.isObject() ? TRI_VPackGet(base, "_key", &_options) : VPackSlice();
+    if (key.isString()) {
+      std::string name;
+      if (!lookup(cid, name)) {
+        // unknown collection (e.g. dropped meanwhile), use its id
+        name = std::to_string(cid);
+      }
+      return name + "/" + key.copyString();
+    }
+  }
+  return "cannot handle custom _id value";
+}
+
+bool CollectionNameResolver::lookup(uint64_t cid, std::string& name) const {
+  std::lock_guard<std::mutex> guard(_mutex);
+  auto it = _names.find(cid);
+  if (it == _names.end()) {
+    return false;
+  }
+  name = it->second;
+  return true;
+}
+
+// collects the collection ids of all custom _id values in slice
+static void CollectCustomIds(VPackSlice const& slice, std::unordered_set<uint64_t>& ids) {
+  switch (slice.type()) {
+    case VPackValueType::Custom: {
+      ids.insert(CustomCollectionId(slice));
+      break;
+    }
+    case VPackValueType::Array: {
+      for (auto const& it : VPackArrayIterator(slice)) {
+        CollectCustomIds(it, ids);
+      }
+      break;
+    }
+    case VPackValueType::Object: {
+      // keys stay untranslated, only the values matter
+      for (VPackObjectIterator it(slice, true); it.valid(); it.next()) {
+        CollectCustomIds(it.value(), ids);
+      }
+      break;
+    }
+    case VPackValueType::External: {
+      CollectCustomIds(slice.resolveExternal(), ids);
+      break;
+    }
+    default: { break; }
+  }
+}
+
+bool CollectionNameResolver::hasUnknownIds(std::string const& database, VPackSlice const& slice) {
+  std::unordered_set<uint64_t> ids;
+  CollectCustomIds(slice, ids);
+  if (ids.empty()) {
+    return false;
+  }
+  bool found = false;
+  std::lock_guard<std::mutex> guard(_mutex);
+  for (auto cid : ids) {
+    if (_names.find(cid) == _names.end() && _missing.find(cid) == _missing.end()) {
+      _unknown[database].insert(cid);
+      found = true;
+    }
+  }
+  return found;
+}
+
+bool CollectionNameResolver::waitForRefresh(std::string const& database, std::function<void()> done) {
+  std::lock_guard<std::mutex> guard(_mutex);
+  auto& waiting = _waiting[database];
+  waiting.push_back(std::move(done));
+  // the first waiter starts the refresh
+  return waiting.size() == 1;
+}
+
+// parses the decimal collection id in slice, returns false if it is none
+static bool ParseCollectionId(VPackSlice const& slice, uint64_t& cid) {
+  if (!slice.isString()) {
+    return false;
+  }
+  ::arangodb::velocypack::ValueLength l;
+  char const* p = slice.getString(l);
+  if (l == 0) {
+    return false;
+  }
+  uint64_t value = 0;
+  for (::arangodb::velocypack::ValueLength i = 0; i < l; ++i) {
+    if (p[i] < '0' || p[i] > '9') {
+      return false;
+    }
+    uint64_t digit = static_cast<uint64_t>(p[i] - '0');
+    if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+      return false;
+    }
+    value = value * 10 + digit;
+  }
+  cid = value;
+  return true;
+}
+
+void CollectionNameResolver::refresh(std::string const& database, VPackSlice const& collections) {
+  std::unordered_map<uint64_t, std::string> names;
+  bool valid = collections.isArray();
+  if (valid) {
+    try {
+      for (auto const& it : VPackArrayIterator(collections)) {
+        if (!it.isObject()) {
+          continue;
+        }
+        uint64_t cid;
+        VPackSlice name = TRI_VPackGet(it, "name", &_options);
+        if (ParseCollectionId(TRI_VPackGet(it, "id", &_options), cid) && name.isString()) {
+          names.emplace(cid, name.copyString());
+        }
+      }
+    } catch (...) {
+      // invalid list, keep the cache but release the waiting requests
+      valid = false;
+    }
+  }
+  std::vector<std::function<void()>> waiting;
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (valid) {
+      for (auto& it : names) {
+        _names[it.first] = std::move(it.second);
+        _missing.erase(it.first);
+      }
+      // whatever is still unknown is not in this database (anymore)
+      for (auto cid : _unknown[database]) {
+        if (_names.find(cid) == _names.end()) {
+          _missing.insert(cid);
+        }
+      }
+    }
+    _unknown.erase(database);
+    auto it = _waiting.find(database);
+    if (it != _waiting.end()) {
+      waiting.swap(it->second);
+      _waiting.erase(it);
+    }
+  }
+  for (auto& done : waiting) {
+    done();
+  }
+}
+
 /// @brief converts a VelocyValueType::String into a V8 object
 static inline v8::Local<v8::Value> ObjectVPackString(v8::Isolate* isolate,
                                                      VPackSlice const& slice) {
@@ -108,6 +283,85 @@ static inline v8::Local<v8::Value> ObjectVPackString(v8::Isolate* isolate,
   }
 }
 
+// names of the system attributes, indexed by their translated id
+static char const* const SystemAttributes[] = {
+  nullptr, "_key", "_rev", "_id", "_from", "_to"
+};
+
+// internalized V8 strings of the system attributes, indexed by their id
+static Nan::Persistent<v8::String> SystemAttributeNames[ToAttribute - AttributeBase + 1];
+
+/// @brief returns the string of a translated (integer) attribute name
+static VPackSlice TranslateAttribute(VPackSlice const& key, VPackOptions const* options) {
+  uint8_t const* name = nullptr;
+  if (options->attributeTranslator != nullptr) {
+    name = options->attributeTranslator->translate(key.getUInt());
+  }
+  if (name == nullptr) {
+    throw std::invalid_argument("cannot translate attribute name " + std::to_string(key.getUInt()));
+  }
+  return VPackSlice(name);
+}
+
+/// @brief converts a translated (integer) attribute name into a V8 string
+static inline v8::Local<v8::String> TranslatedAttributeName(VPackSlice const& key,
+                                                            VPackOptions const* options) {
+  uint64_t id = key.getUInt();
+  if (id >= KeyAttribute - AttributeBase && id <= ToAttribute - AttributeBase) {
+    return Nan::New(SystemAttributeNames[id]);
+  }
+  // not one of ours, needs the translator of the options
+  VPackSlice name = TranslateAttribute(key, options);
+  ::arangodb::velocypack::ValueLength l;
+  char const* p = name.getString(l);
+  return TRI_V8_PAIR_STRING(p, l);
+}
+
+VPackSlice TRI_VPackGet(VPackSlice const& object, std::string const& name,
+                        VPackOptions const* options) {
+  for (VPackObjectIterator it(object, true); it.valid(); it.next()) {
+    VPackSlice key = it.key(false);
+    if (key.isString() ? key.isEqualString(name)
+                       : TranslateAttribute(key, options).isEqualString(name)) {
+      return it.value();
+    }
+  }
+  return VPackSlice();
+}
+
+/// @brief copies slice into builder, with translated attribute names
+/// replaced by their strings (as member `key` of the open object, if set)
+static void CopyUntranslated(VPackSlice const& slice, VPackBuilder& builder,
+                             VPackOptions const* options, std::string const* key) {
+  VPackSlice value = slice.resolveExternal();
+  if (!value.isObject() && !value.isArray()) {
+    if (key != nullptr) {
+      builder.add(*key, value);
+    } else {
+      builder.add(value);
+    }
+    return;
+  }
+  auto type = value.isObject() ? VPackValueType::Object : VPackValueType::Array;
+  if (key != nullptr) {
+    builder.add(*key, VPackValue(type));
+  } else {
+    builder.add(VPackValue(type));
+  }
+  if (value.isObject()) {
+    for (VPackObjectIterator it(value, true); it.valid(); it.next()) {
+      VPackSlice k = it.key(false);
+      std::string name = k.isString() ? k.copyString() : TranslateAttribute(k, options).copyString();
+      CopyUntranslated(it.value(), builder, options, &name);
+    }
+  } else {
+    for (auto const& it : VPackArrayIterator(value)) {
+      CopyUntranslated(it, builder, options, nullptr);
+    }
+  }
+  builder.close();
+}
+
 /// @brief converts a VelocyValueType::Object into a V8 object
 static v8::Local<v8::Value> ObjectVPackObject(v8::Isolate* isolate,
                                                VPackSlice const& slice,
@@ -125,12 +379,18 @@ static v8::Local<v8::Value> ObjectVPackObject(v8::Isolate* isolate,
     VPackObjectIterator it(slice, true);
     while (it.valid()) {
       ::arangodb::velocypack::ValueLength l;
-      VPackSlice k = it.key();
-
-      // regular attribute
-      char const* p = k.getString(l);
-      object->ForceSet(TRI_V8_PAIR_STRING(p, l),
-                       TRI_VPackToV8(isolate, it.value(), options, &slice));
+      VPackSlice k = it.key(false);
+
+      if (k.isString()) {
+        // regular attribute
+        char const* p = k.getString(l);
+        object->ForceSet(TRI_V8_PAIR_STRING(p, l),
+                         TRI_VPackToV8(isolate, it.value(), options, &slice));
+      } else {
+        // translated attribute
+        object->ForceSet(TranslatedAttributeName(k, options),
+                         TRI_VPackToV8(isolate, it.value(), options, &slice));
+      }
 
       //check out of memory
       it.next();
@@ -269,6 +529,277 @@ v8::Local<v8::Value> TRI_VPackToV8(v8::Isolate* isolate,
   return Nan::Undefined(); //avoid warning
 }
 
+/// @brief converts the parts of a VPack value selected by a projection
+v8::Local<v8::Value> TRI_VPackToV8Projected(v8::Isolate* isolate,
+                                             VPackSlice const& slice,
+                                             ProjectionNode const& projection,
+                                             VPackOptions const* options,
+                                             VPackSlice const* base) {
+  try {
+    if (projection.leaf) {
+      return TRI_VPackToV8(isolate, slice, options, base);
+    }
+    if (slice.isExternal()) {
+      return TRI_VPackToV8Projected(isolate, slice.resolveExternal(),
+                                    projection, options, base);
+    }
+    if (slice.isArray()) {
+      v8::Local<v8::Array> array =
+          Nan::New<v8::Array>(static_cast<int>(slice.length()));
+      uint32_t j = 0;
+      for (auto const& it : VPackArrayIterator(slice)) {
+        array->Set(j++, TRI_VPackToV8Projected(isolate, it, projection,
+                                               options, &slice));
+      }
+      return array;
+    }
+    if (slice.isObject()) {
+      v8::Local<v8::Object> object = Nan::New<v8::Object>();
+      for (auto const& child : projection.children) {
+        // attribute lookup instead of iterating all members
+        VPackSlice value = TRI_VPackGet(slice, child->name, options);
+        if (value.isNone()) {
+          continue;
+        }
+        v8::Local<v8::Value> val =
+            TRI_VPackToV8Projected(isolate, value, *child, options, &slice);
+        if (!val->IsUndefined()) {
+          object->ForceSet(TRI_V8_STD_STRING(child->name), val);
+        }
+      }
+      return object;
+    }
+  } catch (std::exception const& e) {
+    isolate->ThrowException(
+        v8::Exception::Error(
+          v8::String::NewFromUtf8(isolate, e.what())
+        )
+    );
+  }
+  // path does not continue in a non-object value
+  return Nan::Undefined();
+}
+
+/// @brief adds a dotted attribute path to a projection
+void TRI_AddProjectionPath(ProjectionNode& root, std::string const& path) {
+  if (path.empty()) {
+    throw std::invalid_argument("empty projection path");
+  }
+  ProjectionNode* node = &root;
+  std::size_t start = 0;
+  while (!node->leaf) {
+    auto end = path.find('.', start);
+    auto name = path.substr(start, end == std::string::npos ? std::string::npos
+                                                            : end - start);
+    ProjectionNode* next = nullptr;
+    for (auto const& child : node->children) {
+      if (child->name == name) {
+        next = child.get();
+        break;
+      }
+    }
+    if (next == nullptr) {
+      node->children.emplace_back(new ProjectionNode());
+      next = node->children.back().get();
+      next->name = name;
+    }
+    node = next;
+    if (end == std::string::npos) {
+      // a leaf covers everything below it
+      node->leaf = true;
+      node->children.clear();
+      break;
+    }
+    start = end + 1;
+  }
+}
+
+/// @brief parses a js column specification
+std::vector<ColumnSpec> TRI_V8ToColumnSpecs(v8::Local<v8::Value> const value) {
+  if (!value->IsObject() || value->IsArray()) {
+    throw std::invalid_argument("expected an object with column types");
+  }
+  v8::Local<v8::Object> o = value->ToObject();
+  v8::Local<v8::Array> names = o->GetOwnPropertyNames();
+  uint32_t const n = names->Length();
+
+  std::vector<ColumnSpec> columns;
+  columns.reserve(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    v8::Local<v8::Value> key = names->Get(i);
+    v8::String::Utf8Value name(key);
+    v8::String::Utf8Value type(o->Get(key));
+    std::string t(*type, type.length());
+
+    ColumnSpec column{std::string(*name, name.length()), ColumnType::Any};
+    if (t == "float64") {
+      column.type = ColumnType::Float64;
+    } else if (t == "int32") {
+      column.type = ColumnType::Int32;
+    } else if (t == "uint32") {
+      column.type = ColumnType::Uint32;
+    } else if (t == "string") {
+      column.type = ColumnType::String;
+    } else if (t != "any") {
+      throw std::invalid_argument("unknown column type '" + t + "'");
+    }
+    columns.push_back(std::move(column));
+  }
+  return columns;
+}
+
+/// @brief converts an array of objects into columns
+v8::Local<v8::Value> TRI_VPackToV8Columns(v8::Isolate* isolate,
+                                           VPackSlice const& slice,
+                                           std::vector<ColumnSpec> const& columns,
+                                           VPackOptions const* options) {
+  try {
+    VPackSlice rows = slice.resolveExternal();
+    if (rows.isObject()) {
+      // cursor results
+      rows = TRI_VPackGet(rows, "result", options);
+    }
+    if (!rows.isArray()) {
+      throw std::invalid_argument("expected an array of rows");
+    }
+    uint32_t const n = static_cast<uint32_t>(rows.length());
+
+    // one output per column, typed arrays are filled through their storage
+    struct Output {
+      ColumnType type;
+      void* data;
+      v8::Local<v8::Array> values;
+    };
+    std::vector<Output> outputs;
+    outputs.reserve(columns.size());
+    v8::Local<v8::Object> result = Nan::New<v8::Object>();
+
+    for (auto const& column : columns) {
+      Output out{column.type, nullptr, v8::Local<v8::Array>()};
+      v8::Local<v8::Value> value;
+      switch (column.type) {
+        case ColumnType::Float64: {
+          auto buffer = v8::ArrayBuffer::New(isolate, n * sizeof(double));
+          out.data = buffer->GetContents().Data();
+          value = v8::Float64Array::New(buffer, 0, n);
+          break;
+        }
+        case ColumnType::Int32: {
+          auto buffer = v8::ArrayBuffer::New(isolate, n * sizeof(int32_t));
+          out.data = buffer->GetContents().Data();
+          value = v8::Int32Array::New(buffer, 0, n);
+          break;
+        }
+        case ColumnType::Uint32: {
+          auto buffer = v8::ArrayBuffer::New(isolate, n * sizeof(uint32_t));
+          out.data = buffer->GetContents().Data();
+          value = v8::Uint32Array::New(buffer, 0, n);
+          break;
+        }
+        case ColumnType::String:
+        case ColumnType::Any: {
+          out.values = Nan::New<v8::Array>(static_cast<int>(n));
+          value = out.values;
+          break;
+        }
+      }
+      result->ForceSet(TRI_V8_STD_STRING(column.name), value);
+      outputs.push_back(out);
+    }
+
+    uint32_t j = 0;
+    for (auto const& it : VPackArrayIterator(rows)) {
+      VPackSlice row = it.resolveExternal();
+      for (std::size_t c = 0; c < columns.size(); ++c) {
+        VPackSlice value = row.isObject() ? TRI_VPackGet(row, columns[c].name, options) : VPackSlice();
+        auto& out = outputs[c];
+        switch (out.type) {
+          case ColumnType::Float64: {
+            // missing or non-numeric values become NaN
+            static_cast<double*>(out.data)[j] = value.isNumber()
+                ? value.getNumber<double>() : std::nan("");
+            break;
+          }
+          case ColumnType::Int32: {
+            double d = value.isNumber() ? value.getNumber<double>() : 0.0;
+            static_cast<int32_t*>(out.data)[j] =
+                (d >= -2147483648.0 && d <= 2147483647.0) ? static_cast<int32_t>(d) : 0;
+            break;
+          }
+          case ColumnType::Uint32: {
+            double d = value.isNumber() ? value.getNumber<double>() : 0.0;
+            static_cast<uint32_t*>(out.data)[j] =
+                (d >= 0.0 && d <= 4294967295.0) ? static_cast<uint32_t>(d) : 0;
+            break;
+          }
+          case ColumnType::String: {
+            if (value.isString()) {
+              out.values->Set(j, ObjectVPackString(isolate, value));
+            } else {
+              out.values->Set(j, Nan::Null());
+            }
+            break;
+          }
+          case ColumnType::Any: {
+            if (!value.isNone()) {
+              out.values->Set(j, TRI_VPackToV8(isolate, value, options, &row));
+            }
+            break;
+          }
+        }
+      }
+      ++j;
+    }
+    return result;
+  } catch (std::exception const& e) {
+    isolate->ThrowException(
+        v8::Exception::Error(
+          v8::String::NewFromUtf8(isolate, e.what())
+        )
+    );
+  }
+  return Nan::Undefined();
+}
+
+/// @brief renders slices as JSON text
+static void DumpJson(std::vector<VPackSlice> const& slices,
+                     VPackOptions const* options, std::string& out) {
+  VPackStringSink sink(&out);
+  VPackDumper dumper(&sink, options);
+  if (slices.size() == 1) {
+    dumper.dump(slices[0]);
+    return;
+  }
+  sink.push_back('[');
+  bool first = true;
+  for (auto const& slice : slices) {
+    if (!first) {
+      sink.push_back(',');
+    }
+    first = false;
+    dumper.dump(slice);
+  }
+  sink.push_back(']');
+}
+
+void TRI_VPackToJson(std::vector<VPackSlice> const& slices,
+                     VPackOptions const* options, std::string& out) {
+  try {
+    DumpJson(slices, options, out);
+  } catch (VPackException const&) {
+    // The Dumper only translates attribute names with the translator of
+    // Options::Defaults, which has none. Dump a copy with string keys.
+    std::vector<VPackBuilder> copies(slices.size());
+    std::vector<VPackSlice> untranslated;
+    for (std::size_t i = 0; i < slices.size(); ++i) {
+      CopyUntranslated(slices[i], copies[i], options, nullptr);
+      untranslated.push_back(copies[i].slice());
+    }
+    out.clear();
+    DumpJson(untranslated, options, out);
+  }
+}
+
 struct BuilderContext {
   BuilderContext(v8::Isolate* isolate, VPackBuilder& builder,
                  bool keepTopLevelOpen)
@@ -296,6 +827,55 @@ static inline void AddValue(BuilderContext& context,
   }
 }
 
+// memoized encodings of frozen objects (see vpackMemoize). The object
+// references its entry through a private property (MemoizedKey), so
+// objects that were never memoized are looked up without creating an
+// identity hash for them. Entries are removed when the object is garbage
+// collected.
+struct MemoizedValue {
+  Nan::Persistent<v8::Object> object;
+  // encoded with translated system attributes (see vpackTranslateAttributes)
+  bool translated;
+  std::shared_ptr<VPBuffer> bytes;
+};
+static std::unordered_map<MemoizedValue const*, std::unique_ptr<MemoizedValue>> MemoizedValues;
+static Nan::Persistent<v8::Private> MemoizedKey;
+
+/// @brief finds the memoized encoding of an object
+static MemoizedValue const* LookupMemoized(v8::Local<v8::Object> const& object) {
+  auto isolate = v8::Isolate::GetCurrent();
+  v8::Local<v8::Value> value;
+  if (!object->GetPrivate(isolate->GetCurrentContext(), MemoizedKey.Get(isolate)).ToLocal(&value) ||
+      !value->IsExternal()) {
+    return nullptr;
+  }
+  return static_cast<MemoizedValue const*>(v8::Local<v8::External>::Cast(value)->Value());
+}
+
+/// @brief removes a memoized encoding and releases its memory, object is
+/// empty if it has been garbage collected
+static void ForgetMemoized(MemoizedValue const* value, v8::Local<v8::Object> const& object) {
+  auto it = MemoizedValues.find(value);
+  if (it == MemoizedValues.end()) {
+    return;
+  }
+  if (!object.IsEmpty()) {
+    auto isolate = v8::Isolate::GetCurrent();
+    object->DeletePrivate(isolate->GetCurrentContext(), MemoizedKey.Get(isolate));
+    // a weak handle must be cleared before it is reset, or the callback
+    // info Nan allocated in SetWeak is leaked (after a collection Nan
+    // releases it itself)
+    delete it->second->object.ClearWeak<Nan::WeakCallbackInfo<MemoizedValue>>();
+  }
+  adjustExternalMemory(-static_cast<int64_t>(value->bytes->size()));
+  it->second->object.Reset();
+  MemoizedValues.erase(it);
+}
+
+static void MemoizedValueCollected(Nan::WeakCallbackInfo<MemoizedValue> const& data) {
+  ForgetMemoized(data.GetParameter(), v8::Local<v8::Object>());
+}
+
 /// @brief convert a V8 value to a VPack value
 template <bool performAllChecks, bool inObject>
 int V8ToVPack(BuilderContext& context,
@@ -345,6 +925,19 @@ int V8ToVPack(BuilderContext& context,
       return TRI_ERROR_NO_ERROR;
     }
 
+    if (!MemoizedValues.empty() && parameter->IsObject() &&
+        (context.level > 0 || !context.keepTopLevelOpen)) {
+      // splice in the bytes of a memoized (frozen) object
+      auto memoized = LookupMemoized(v8::Local<v8::Object>::Cast(parameter));
+      // the bytes are only valid for the translation they were encoded with
+      if (memoized != nullptr &&
+          memoized->translated == (context.builder.options->attributeTranslator != nullptr)) {
+        AddValue<VPackSlice, inObject>(context, attributeName,
+                                       VPackSlice(memoized->bytes->data()));
+        return TRI_ERROR_NO_ERROR;
+      }
+    }
+
     if (parameter->IsArray()) {
       v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(parameter);
 
@@ -522,7 +1115,28 @@ int TRI_V8ToVPack(v8::Isolate* isolate, VPackBuilder& builder,
   return rv;
 }
 
+/// @brief convert a V8 value to VPack value, added under the given attribute name
+int TRI_V8ToVPack(v8::Isolate* isolate, VPackBuilder& builder,
+                  arangodb::StringRef const& attributeName,
+                  v8::Local<v8::Value> const value) {
+  int rv = 1; //signals error
+  try {
+    Nan::HandleScope scope;
+    BuilderContext context(isolate, builder, false);
+    context.toJsonKey = Nan::New("toJSON").ToLocalChecked();
+    rv = V8ToVPack<true, true>(context, value, attributeName);
+  } catch(std::exception const& e) {
+    isolate->ThrowException(
+        v8::Exception::Error(
+          v8::String::NewFromUtf8(isolate, e.what())
+        )
+    );
+  }
+  return rv;
+}
+
 // node interface ////////////////////////////////////////////////////////////////////////////////
+
 NAN_METHOD(vpackDecode) {
   //std::cout << "node-velocypack decode - ";
   if (info.Length() < 1) {
@@ -538,7 +1152,14 @@ NAN_METHOD(vpackDecode) {
     }
     VPackSlice slice(buf);
     //std::cout << "####" << slice.toJson() << "###" << std::endl;
-    info.GetReturnValue().Set(TRI_VPackToV8(info.GetIsolate(), slice, &::arangodb::velocypack::Options::Defaults));
+    auto options = TRI_DecodeOptions();
+    std::unique_ptr<ProjectionNode> compiled;
+    auto projection = decodeProjection(info, compiled);
+    if (projection != nullptr) {
+      info.GetReturnValue().Set(TRI_VPackToV8Projected(info.GetIsolate(), slice, *projection, options));
+      return;
+    }
+    info.GetReturnValue().Set(TRI_VPackToV8(info.GetIsolate(), slice, options));
   } catch (std::exception const& e) {
     std::string errorMessage = std::string("node-velocypack - Error while decoding: ") + e.what();
     Nan::ThrowError(errorMessage.c_str());
@@ -548,6 +1169,143 @@ NAN_METHOD(vpackDecode) {
   }
 }
 
+NAN_METHOD(vpackDecodeColumns) {
+  if (info.Length() < 2) {
+      Nan::ThrowRangeError("node-velocypack - Error while decoding columns: expected buffer and column specification");
+      return;
+  }
+  try {
+    char* buf = ::node::Buffer::Data(info[0]);
+    if (buf == nullptr) {
+      std::string errorMessage = std::string("node-velocypack - Error while decoding columns: given buffer is NULL");
+      Nan::ThrowError(errorMessage.c_str());
+      return;
+    }
+    auto columns = TRI_V8ToColumnSpecs(info[1]);
+    VPackSlice slice(buf);
+    info.GetReturnValue().Set(TRI_VPackToV8Columns(info.GetIsolate(), slice, columns, TRI_DecodeOptions()));
+  } catch (std::exception const& e) {
+    std::string errorMessage = std::string("node-velocypack - Error while decoding columns: ") + e.what();
+    Nan::ThrowError(errorMessage.c_str());
+  } catch (...) {
+    std::string errorMessage = std::string("node-velocypack - Unknown error while decoding columns");
+    Nan::ThrowError(errorMessage.c_str());
+  }
+}
+
+NAN_METHOD(vpackDecodeMany) {
+  if (info.Length() < 1) {
+      Nan::ThrowRangeError("node-velocypack - Error while decoding: no arguments given");
+      return;
+  }
+  try {
+    auto isolate = info.GetIsolate();
+    auto options = TRI_DecodeOptions();
+    std::unique_ptr<ProjectionNode> compiled;
+    auto projection = decodeProjection(info, compiled);
+    auto decode = [&](VPackSlice const& slice) {
+      if (projection != nullptr) {
+        return TRI_VPackToV8Projected(isolate, slice, *projection, options);
+      }
+      return TRI_VPackToV8(isolate, slice, options);
+    };
+
+    v8::Local<v8::Array> result;
+    if (info[0]->IsArray()) {
+      // list of Buffers, each containing one slice
+      auto buffers = v8::Local<v8::Array>::Cast(info[0]);
+      uint32_t const n = buffers->Length();
+      result = Nan::New<v8::Array>(static_cast<int>(n));
+      for (uint32_t i = 0; i < n; ++i) {
+        auto buffer = buffers->Get(i);
+        if (!::node::Buffer::HasInstance(buffer)) {
+          Nan::ThrowTypeError("node-velocypack - Error while decoding: expected array of Buffers");
+          return;
+        }
+        result->Set(i, decode(VPackSlice(::node::Buffer::Data(buffer))));
+      }
+    } else if (::node::Buffer::HasInstance(info[0])) {
+      // one Buffer containing concatenated slices
+      auto data = reinterpret_cast<uint8_t const*>(::node::Buffer::Data(info[0]));
+      auto length = ::node::Buffer::Length(info[0]);
+      result = Nan::New<v8::Array>();
+      uint32_t i = 0;
+      std::size_t offset = 0;
+      while (offset < length) {
+        VPackSlice slice(data + offset);
+        auto size = static_cast<std::size_t>(slice.byteSize());
+        if (size == 0 || offset + size > length) {
+          Nan::ThrowError("node-velocypack - Error while decoding: buffer does not end with an entire slice");
+          return;
+        }
+        result->Set(i++, decode(slice));
+        offset += size;
+      }
+    } else {
+      Nan::ThrowTypeError("node-velocypack - Error while decoding: expected Buffer or array of Buffers");
+      return;
+    }
+    info.GetReturnValue().Set(result);
+  } catch (std::exception const& e) {
+    std::string errorMessage = std::string("node-velocypack - Error while decoding: ") + e.what();
+    Nan::ThrowError(errorMessage.c_str());
+  } catch (...) {
+    std::string errorMessage = std::string("node-velocypack - Unknown error while decoding");
+    Nan::ThrowError(errorMessage.c_str());
+  }
+}
+
+NAN_METHOD(vpackEncodeMany) {
+  if (info.Length() < 1 || !info[0]->IsArray()) {
+      Nan::ThrowRangeError("node-velocypack - Error while encoding: expected array of values");
+      return;
+  }
+
+  try {
+    auto isolate = info.GetIsolate();
+    auto values = v8::Local<v8::Array>::Cast(info[0]);
+    uint32_t const n = values->Length();
+
+    // offsets[i] is the start of slice i, offsets[n] the total length
+    auto offsetBuffer = v8::ArrayBuffer::New(isolate, (n + 1) * sizeof(uint32_t));
+    auto offsets = static_cast<uint32_t*>(offsetBuffer->GetContents().Data());
+
+    // every builder appends to the end of the shared buffer, so the slices
+    // are encoded back to back in place
+    auto out = std::make_shared<VPBuffer>();
+    for (uint32_t i = 0; i < n; ++i) {
+      offsets[i] = static_cast<uint32_t>(out->size());
+      VPackBuilder builder(out, TRI_EncodeOptions());
+      auto tri = TRI_V8ToVPack(isolate, builder, values->Get(i), false);
+      if (tri != TRI_ERROR_NO_ERROR) {
+          std::string errorMessage = std::string("node-velocypack - Error while encoding value ") + std::to_string(i) + ": TRI_ERROR(" + std::to_string(tri) + ")";
+          Nan::ThrowError(errorMessage.c_str());
+          return;
+      }
+      if (out->size() > std::numeric_limits<uint32_t>::max()) {
+          Nan::ThrowRangeError("node-velocypack - Error while encoding: values exceed 4GB");
+          return;
+      }
+    }
+    offsets[n] = static_cast<uint32_t>(out->size());
+
+    // hand out the buffer without copying it
+    auto result = Nan::New<v8::Object>();
+    Nan::Set(result, Nan::New("buffer").ToLocalChecked(),
+             externalBuffer(reinterpret_cast<char const*>(out->data()), out->size(),
+                            accountExternal(out, out->size())));
+    Nan::Set(result, Nan::New("offsets").ToLocalChecked(),
+             v8::Uint32Array::New(offsetBuffer, 0, n + 1));
+    info.GetReturnValue().Set(result);
+  } catch (std::exception const& e){
+    std::string errorMessage = std::string("node-velocypack - Error while encoding: ") + e.what();
+    Nan::ThrowError(errorMessage.c_str());
+  } catch (...) {
+    std::string errorMessage = std::string("node-velocypack - Unknown error while encoding");
+    Nan::ThrowError(errorMessage.c_str());
+  }
+}
+
 NAN_METHOD(vpackEncode) {
   //std::cout << "node-velocypack encode";
   if (info.Length() < 1) {
@@ -561,17 +1319,16 @@ NAN_METHOD(vpackEncode) {
   }
 
   try {
-    VPackBuilder builder;
-    auto tri = TRI_V8ToVPack(info.GetIsolate(), builder, info[0], false);
+    PooledBuilder builder;
+    auto tri = TRI_V8ToVPack(info.GetIsolate(), *builder, info[0], false);
     if (tri != TRI_ERROR_NO_ERROR) {
         std::string errorMessage = std::string("node-velocypack - Error while encoding: TRI_ERROR(") + std::to_string(tri) + ")";
         Nan::ThrowError(errorMessage.c_str());
         return;
     }
 
-    auto l = builder.slice().byteSize();
-    auto buffer = builder.buffer();
-    info.GetReturnValue().Set(Nan::CopyBuffer((char*)buffer->data(), l).ToLocalChecked());
+    auto slice = builder->slice();
+    info.GetReturnValue().Set(Nan::CopyBuffer(slice.startAs<char>(), slice.byteSize()).ToLocalChecked());
   } catch (std::exception const& e){
     std::string errorMessage = std::string("node-velocypack - Error while encoding: ") + e.what();
     Nan::ThrowError(errorMessage.c_str());
@@ -581,28 +1338,121 @@ NAN_METHOD(vpackEncode) {
   }
 }
 
-static std::unique_ptr<VPackCustomTypeHandler> CustomTypeHandler;
+/// @brief returns true if value and everything reachable from it is frozen
+static bool IsDeepFrozen(v8::Local<v8::Object> const& objectCtor,
+                         v8::Local<v8::Function> const& isFrozen,
+                         v8::Local<v8::Value> const& value, int level) {
+  if (!value->IsObject()) {
+    return true;
+  }
+  if (level > MaxLevels) {
+    return false;
+  }
+  auto object = v8::Local<v8::Object>::Cast(value);
+  v8::Local<v8::Value> argv[1] = { object };
+  if (!isFrozen->Call(objectCtor, 1, argv)->BooleanValue()) {
+    return false;
+  }
+  v8::Local<v8::Array> names = object->GetOwnPropertyNames();
+  for (uint32_t i = 0; i < names->Length(); ++i) {
+    if (!IsDeepFrozen(objectCtor, isFrozen, object->Get(names->Get(i)), level + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
 
-/*class VPackEnvironment {
-public:
-  VPackEnvironment(): translator(new VPackAttributeTranslator()) {
-    auto tx = translator.get();
-    tx->add("_key", 1);
-    tx->add("_rev", 2);
-    tx->add("_id", 3);
-    tx->add("_from", 4);
-    tx->add("_to", 5);
-    tx->seal();
-    //Translator.reset(tx);
-    auto& opts = ::arangodb::velocypack::Options::Defaults;
-    opts.attributeTranslator = tx;
+/// @brief caches the encoding of a frozen object or array, which is then
+/// reused whenever the same object is encoded (until it is garbage collected
+/// or passed to vpackForget)
+NAN_METHOD(vpackMemoize) {
+  if (info.Length() != 1 || !info[0]->IsObject()) {
+    Nan::ThrowTypeError("node-velocypack - vpackMemoize expects an object or array");
+    return;
   }
+  try {
+    auto object = v8::Local<v8::Object>::Cast(info[0]);
+    // only deeply frozen objects can be memoized, others could still change
+    auto objectCtor = Nan::Get(Nan::GetCurrentContext()->Global(), Nan::New("Object").ToLocalChecked()).ToLocalChecked()->ToObject();
+    auto isFrozen = v8::Local<v8::Function>::Cast(Nan::Get(objectCtor, Nan::New("isFrozen").ToLocalChecked()).ToLocalChecked());
+    if (!IsDeepFrozen(objectCtor, isFrozen, object, 0)) {
+      Nan::ThrowTypeError("node-velocypack - vpackMemoize expects a deeply frozen object (see fuerte.freeze)");
+      return;
+    }
+    auto memoized = LookupMemoized(object);
+    bool const translated = (TRI_EncodeOptions()->attributeTranslator != nullptr);
+    if (memoized != nullptr && memoized->translated != translated) {
+      // encoded with another translation setting, encode again
+      ForgetMemoized(memoized, object);
+      memoized = nullptr;
+    }
+    if (memoized == nullptr) {
+      VPackBuilder builder(TRI_EncodeOptions());
+      auto tri = TRI_V8ToVPack(info.GetIsolate(), builder, object, false);
+      if (tri != TRI_ERROR_NO_ERROR) {
+        std::string errorMessage = std::string("node-velocypack - Error while memoizing: TRI_ERROR(") + std::to_string(tri) + ")";
+        Nan::ThrowError(errorMessage.c_str());
+        return;
+      }
+      std::unique_ptr<MemoizedValue> value(new MemoizedValue());
+      value->translated = translated;
+      value->bytes = builder.steal();
+      value->object.Reset(object);
+      value->object.SetWeak(value.get(), MemoizedValueCollected, Nan::WeakCallbackType::kParameter);
+      adjustExternalMemory(static_cast<int64_t>(value->bytes->size()));
+      // private properties can be added to frozen objects
+      auto isolate = info.GetIsolate();
+      object->SetPrivate(isolate->GetCurrentContext(), MemoizedKey.Get(isolate),
+                         v8::External::New(isolate, value.get()));
+      auto key = value.get();
+      MemoizedValues.emplace(key, std::move(value));
+    }
+    info.GetReturnValue().Set(object);
+  } catch (std::exception const& e) {
+    std::string errorMessage = std::string("node-velocypack - Error while memoizing: ") + e.what();
+    Nan::ThrowError(errorMessage.c_str());
+  }
+}
 
-private:
-  std::unique_ptr<VPackAttributeTranslator> translator;
-};
+/// @brief drops the cached encoding of an object
+NAN_METHOD(vpackForget) {
+  if (info.Length() != 1 || !info[0]->IsObject()) {
+    Nan::ThrowTypeError("node-velocypack - vpackForget expects an object or array");
+    return;
+  }
+  auto object = v8::Local<v8::Object>::Cast(info[0]);
+  auto memoized = LookupMemoized(object);
+  if (memoized != nullptr) {
+    ForgetMemoized(memoized, object);
+  }
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(memoized != nullptr));
+}
+
+static std::unique_ptr<VPackCustomTypeHandler> CustomTypeHandler;
+
+// translator for the system attributes, always used for decoding and
+// used for encoding when enabled by vpackTranslateAttributes
+static std::unique_ptr<VPackAttributeTranslator> SystemAttributeTranslator;
+
+static VPackOptions EncodeOptions;
+static VPackOptions DecodeOptions;
 
-static VPackEnvironment _vpackEnd;*/
+VPackOptions const* TRI_EncodeOptions() {
+  return &EncodeOptions;
+}
+
+VPackOptions const* TRI_DecodeOptions() {
+  return &DecodeOptions;
+}
+
+/// @brief enables or disables translating system attribute names on encode
+NAN_METHOD(vpackTranslateAttributes) {
+  bool previous = (EncodeOptions.attributeTranslator != nullptr);
+  if (info.Length() > 0) {
+    EncodeOptions.attributeTranslator = Nan::To<bool>(info[0]).FromJust() ? SystemAttributeTranslator.get() : nullptr;
+  }
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(previous));
+}
 
 NAN_MODULE_INIT(InitVPack) {
 
@@ -610,8 +1460,30 @@ NAN_MODULE_INIT(InitVPack) {
     auto& opts = ::arangodb::velocypack::Options::Defaults;
     opts.customTypeHandler = CustomTypeHandler.get();
 
+    SystemAttributeTranslator.reset(new VPackAttributeTranslator());
+    auto isolate = v8::Isolate::GetCurrent();
+    for (uint8_t id = KeyAttribute - AttributeBase; id <= ToAttribute - AttributeBase; ++id) {
+      SystemAttributeTranslator->add(SystemAttributes[id], id);
+      SystemAttributeNames[id].Reset(
+          v8::String::NewFromUtf8(isolate, SystemAttributes[id],
+                                  v8::NewStringType::kInternalized).ToLocalChecked());
+    }
+    SystemAttributeTranslator->seal();
+    MemoizedKey.Reset(v8::Private::ForApi(isolate, Nan::New("fuerte:memoized").ToLocalChecked()));
+    // Options::Defaults (used by fuerte and every default constructed
+    // Builder/Parser) stays without translator
+    EncodeOptions = opts;
+    DecodeOptions = opts;
+    DecodeOptions.attributeTranslator = SystemAttributeTranslator.get();
+
     NAN_EXPORT(target, vpackEncode);
     NAN_EXPORT(target, vpackDecode);
+    NAN_EXPORT(target, vpackDecodeColumns);
+    NAN_EXPORT(target, vpackEncodeMany);
+    NAN_EXPORT(target, vpackDecodeMany);
+    NAN_EXPORT(target, vpackTranslateAttributes);
+    NAN_EXPORT(target, vpackMemoize);
+    NAN_EXPORT(target, vpackForget);
 }
 
 }}}
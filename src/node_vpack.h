@@ -31,6 +31,14 @@
 #include <velocypack/Builder.h>
 #include <velocypack/velocypack-aliases.h>
 
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 //replaces arangodb string ref
 #include <experimental/string_view>
 
@@ -44,6 +52,69 @@ namespace arangodb { namespace fuerte { namespace js {
 struct BuilderContext;
 using VPBuffer = ::arangodb::velocypack::Buffer<uint8_t>;
 
+// ProjectionNode is one level of a compiled set of attribute paths.
+// The root node has an empty name, leaf nodes select an entire value.
+struct ProjectionNode {
+  std::string name;
+  bool leaf = false;
+  std::vector<std::unique_ptr<ProjectionNode>> children;
+};
+
+// ColumnSpec describes one column of a columnar decode.
+enum class ColumnType { Float64, Int32, Uint32, String, Any };
+struct ColumnSpec {
+  std::string name;
+  ColumnType type;
+};
+
+// CollectionNameResolver is a custom type handler that turns custom _id
+// values into "<collection name>/<key>", using a cache of collection
+// id -> name. It is shared between a connection and its responses.
+// The cache is filled via refresh, which the connection calls with the
+// result of /_api/collection of a database. Collection ids are unique
+// across databases, so the names of all databases share one cache.
+class CollectionNameResolver final : public VPackCustomTypeHandler {
+ public:
+  CollectionNameResolver();
+
+  void dump(VPackSlice const& value, VPackDumper* dumper,
+            VPackSlice const& base) override;
+  std::string toString(VPackSlice const& value, VPackOptions const* options,
+                       VPackSlice const& base) override;
+
+  // options to decode slices with, using this handler
+  VPackOptions const* options() const { return &_options; }
+
+  // returns true if slice (from a response of database) contains a custom
+  // _id value with a collection id that is not in the cache. Those ids are
+  // remembered: if the next refresh of database does not know them either
+  // (e.g. dropped collections), they are not reported again.
+  bool hasUnknownIds(std::string const& database, VPackSlice const& slice);
+
+  // registers done to be called after the next refresh of database.
+  // Returns true if the caller has to start that refresh (none is in
+  // progress yet).
+  bool waitForRefresh(std::string const& database, std::function<void()> done);
+  // adds the names of database (taken from a /_api/collection result) to
+  // the cache and calls all callbacks waiting for database. An invalid
+  // result (e.g. None after a failed request) keeps the cache as it is,
+  // the callbacks are called in any case.
+  void refresh(std::string const& database, VPackSlice const& collections);
+
+ private:
+  bool lookup(uint64_t cid, std::string& name) const;
+
+  mutable std::mutex _mutex;
+  std::unordered_map<uint64_t, std::string> _names;
+  // ids that no refresh knows
+  std::unordered_set<uint64_t> _missing;
+  // unknown ids per database, waiting for its refresh
+  std::unordered_map<std::string, std::unordered_set<uint64_t>> _unknown;
+  // callbacks per database that is being refreshed
+  std::unordered_map<std::string, std::vector<std::function<void()>>> _waiting;
+  VPackOptions _options;
+};
+
 // constants
 static uint8_t const AttributeBase = 0x30;
 static uint8_t const KeyAttribute = 0x31;
@@ -59,21 +130,68 @@ static int const TRI_ERROR_NOT_IMPLEMENTED = 8;
 
 // functions
 
+// options to encode js values (and JSON bodies) with. Attribute names are
+// translated when vpackTranslateAttributes is enabled. Main thread only,
+// other threads get a copy.
+VPackOptions const* TRI_EncodeOptions();
+
+// options to decode velocypack with, they always have the translator of the
+// system attributes and do not change after InitVPack (any thread).
+// Options::Defaults has no translator, so slices with translated keys must
+// not be passed to Slice::get, use TRI_VPackGet instead.
+VPackOptions const* TRI_DecodeOptions();
+
+// returns the member `name` of object (None if it has none), resolving
+// translated attribute names with options
+VPackSlice TRI_VPackGet(VPackSlice const& object, std::string const& name,
+                        VPackOptions const* options);
+
 // decode to js object
 v8::Local<v8::Value> TRI_VPackToV8(v8::Isolate* isolate, VPackSlice const& slice, 
   VPackOptions const* options, VPackSlice const* base = nullptr);
 
+// decode to js object, materializing only the attributes selected by
+// projection (arrays are projected element wise)
+v8::Local<v8::Value> TRI_VPackToV8Projected(v8::Isolate* isolate, VPackSlice const& slice,
+  ProjectionNode const& projection, VPackOptions const* options,
+  VPackSlice const* base = nullptr);
+
+// add a dotted attribute path ("a.b.c") to a projection
+void TRI_AddProjectionPath(ProjectionNode& root, std::string const& path);
+
+// parse a js column specification ({name: "float64"|"int32"|"uint32"|"string"|"any"})
+std::vector<ColumnSpec> TRI_V8ToColumnSpecs(v8::Local<v8::Value> const value);
+
+// decode an array of objects (or an object with a `result` array) into
+// one js column per spec; numeric columns are returned as typed arrays
+v8::Local<v8::Value> TRI_VPackToV8Columns(v8::Isolate* isolate, VPackSlice const& slice,
+  std::vector<ColumnSpec> const& columns, VPackOptions const* options);
+
+// render slices as JSON text (multiple slices are rendered as an array)
+void TRI_VPackToJson(std::vector<VPackSlice> const& slices,
+  VPackOptions const* options, std::string& out);
+
 // encode to vpack
 int TRI_V8ToVPack(v8::Isolate* isolate, VPackBuilder& builder, 
   v8::Local<v8::Value> const value, bool keepTopLevelOpen);
 
+// encode to vpack as member of the currently open object of builder
+int TRI_V8ToVPack(v8::Isolate* isolate, VPackBuilder& builder,
+  arangodb::StringRef const& attributeName, v8::Local<v8::Value> const value);
+
 // this functions does most of the work (template!)
 template <bool performAllChecks, bool inObject>
 int V8ToVPack(BuilderContext& context, v8::Local<v8::Value> const parameter, 
   arangodb::StringRef const& attributeName);
 
 NAN_METHOD(vpackDecode);
+NAN_METHOD(vpackDecodeColumns);
+NAN_METHOD(vpackTranslateAttributes);
 NAN_METHOD(vpackEncode);
+NAN_METHOD(vpackDecodeMany);
+NAN_METHOD(vpackEncodeMany);
+NAN_METHOD(vpackMemoize);
+NAN_METHOD(vpackForget);
 NAN_MODULE_INIT(InitVPack);
 
 }}}
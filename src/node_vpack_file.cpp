@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <velocypack/Validator.h>
+
+#include "node_projection.h"
+#include "node_request.h"
+#include "node_vpack_file.h"
+
+namespace arangodb { namespace fuerte { namespace js {
+
+///////////////////////////////////////////////////////////////////////////////
+// VPackFile //////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// bytes that Slice::byteSize may read (type and length fields)
+static std::size_t const MaxHeaderSize = 16;
+
+void VPackFile::open(std::string const& path) {
+  _file = std::make_shared<MappedFile>(path);
+  _path = path;
+  _offsets.assign(1, 0);
+  _complete = (_file->size() == 0);
+}
+
+// sliceSize returns the size of the slice at pos, without reading beyond
+// the end of the mapping if its header is cut off.
+std::size_t VPackFile::sliceSize(std::size_t pos) const {
+  auto const data = _file->data() + pos;
+  auto const available = _file->size() - pos;
+  if (available >= MaxHeaderSize) {
+    return static_cast<std::size_t>(VPackSlice(data).byteSize());
+  }
+  // near the end: read the header from a zero padded copy
+  uint8_t header[MaxHeaderSize] = {0};
+  std::memcpy(header, data, available);
+  return static_cast<std::size_t>(VPackSlice(header).byteSize());
+}
+
+// validationOptions returns the options slices are validated with. The
+// file is untrusted, so External slices (raw pointers) are rejected.
+static VPackOptions const* validationOptions() {
+  static VPackOptions const options = []() {
+    VPackOptions result = *TRI_DecodeOptions();
+    result.disallowExternals = true;
+    return result;
+  }();
+  return &options;
+}
+
+void VPackFile::indexUntil(std::size_t i) const {
+  auto const size = _file->size();
+  while (!_complete && _offsets.size() <= i + 1) {
+    auto pos = _offsets.back();
+    auto sliceSize = this->sliceSize(pos);
+    if (sliceSize == 0 || sliceSize > size - pos) {
+      throw std::runtime_error("truncated slice at offset " + std::to_string(pos) + " of '" + _path + "'");
+    }
+    // nested headers must stay within the slice too, before anything
+    // decodes it
+    try {
+      VPackValidator validator(validationOptions());
+      validator.validate(_file->data() + pos, sliceSize, false);
+    } catch (std::exception const& e) {
+      throw std::runtime_error("invalid slice at offset " + std::to_string(pos) + " of '" + _path + "': " + e.what());
+    }
+    pos += sliceSize;
+    _offsets.push_back(pos);
+    _complete = (pos == size);
+  }
+}
+
+std::size_t VPackFile::length() const {
+  if (!_file) {
+    return 0;
+  }
+  indexUntil(std::numeric_limits<std::size_t>::max() - 1);
+  return _offsets.size() - 1;
+}
+
+VPackSlice VPackFile::slice(std::size_t i) const {
+  if (_file) {
+    indexUntil(i);
+  }
+  if (!_file || i + 1 >= _offsets.size()) {
+    throw std::out_of_range("slice index " + std::to_string(i) + " out of range");
+  }
+  return VPackSlice(_file->data() + _offsets[i]);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// NVPackFile /////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// sliceIndex returns the slice index argument
+static std::size_t sliceIndex(Nan::FunctionCallbackInfo<v8::Value> const& info, int argIndex) {
+  if (info.Length() <= argIndex || !info[argIndex]->IsUint32()) {
+    throw std::invalid_argument("expected a slice index");
+  }
+  return Nan::To<uint32_t>(info[argIndex]).FromJust();
+}
+
+NAN_METHOD(NVPackFile::New) {
+  try {
+    if (info.IsConstructCall()) {
+      if (info.Length() != 1 || !info[0]->IsString()) {
+        Nan::ThrowTypeError("Expected path argument");
+        return;
+      }
+      auto obj = new NVPackFile();
+      obj->Wrap(info.This());
+      obj->cppClass()->open(to<std::string>(info[0]));
+      info.GetReturnValue().Set(info.This());
+    } else {
+      int argc = info.Length() > 0 ? 1 : 0;
+      v8::Local<v8::Value> argv[1] = {info[0]};
+      info.GetReturnValue().Set(NVPackFile::NewInstance(argc, argv).ToLocalChecked());
+    }
+  } catch(std::exception const& e) {
+    std::string msg = std::string("VPackFile.New binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_METHOD(NVPackFile::slice) {
+  try {
+    auto file = self(info);
+    auto slice = file->slice(sliceIndex(info, 0));
+    // the buffer keeps the mapping alive
+    info.GetReturnValue().Set(externalBuffer(slice.startAs<char>(), slice.byteSize(), file->file()));
+  } catch(std::exception const& e) {
+    std::string msg = std::string("VPackFile.slice binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_METHOD(NVPackFile::decode) {
+  try {
+    auto slice = self(info)->slice(sliceIndex(info, 0));
+    auto options = TRI_DecodeOptions();
+    std::unique_ptr<ProjectionNode> compiled;
+    auto projection = decodeProjection(info, compiled);
+    if (projection != nullptr) {
+      info.GetReturnValue().Set(TRI_VPackToV8Projected(info.GetIsolate(), slice, *projection, options));
+      return;
+    }
+    info.GetReturnValue().Set(TRI_VPackToV8(info.GetIsolate(), slice, options));
+  } catch(std::exception const& e) {
+    std::string msg = std::string("VPackFile.decode binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_METHOD(NVPackFile::addToRequest) {
+  try {
+    if (info.Length() != 2 || !NRequest::HasInstance(info[0])) {
+      Nan::ThrowTypeError("Expected Request and slice index arguments");
+      return;
+    }
+    auto slice = self(info)->slice(sliceIndex(info, 1));
+    // fuerte copies the slice into the request payload
+    unwrap<NRequest>(info[0])->cppClass()->addVPack(slice);
+    info.GetReturnValue().Set(info[0]);
+  } catch(std::exception const& e) {
+    std::string msg = std::string("VPackFile.addToRequest binding failed with exception: ") + e.what();
+    Nan::ThrowError(msg.c_str());
+  }
+}
+
+NAN_GETTER(NVPackFile::getLength) {
+  try {
+    info.GetReturnValue().Set(Nan::New<v8::Number>(static_cast<double>(self(info)->length())));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("VPackFile.length binding failed with exception");
+  }
+}
+
+NAN_GETTER(NVPackFile::getByteSize) {
+  try {
+    info.GetReturnValue().Set(Nan::New<v8::Number>(static_cast<double>(self(info)->byteSize())));
+  } catch(std::exception const& e) {
+    Nan::ThrowError("VPackFile.byteSize binding failed with exception");
+  }
+}
+
+}}}
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////
+/// DISCLAIMER
+///
+/// Copyright 2017 ArangoDB GmbH, Cologne, Germany
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+///
+/// Copyright holder is ArangoDB GmbH, Cologne, Germany
+///
+/// @author Ewout Prangsma
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#ifndef FUERTE_NODE_VPACK_FILE_H
+#define FUERTE_NODE_VPACK_FILE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "node_mapped_file.h"
+#include "node_upstream.h"
+#include "node_vpack.h"
+#include "object_wrap.h"
+
+namespace arangodb { namespace fuerte { namespace js {
+
+// VPackFile provides random access to the slices of a file that contains
+// concatenated velocypack slices. The file is memory mapped, only an
+// index of slice offsets is kept on the heap. The index is built lazily,
+// up to the slice that is accessed (length scans the entire file), and
+// every slice is validated when it is added to the index.
+class VPackFile {
+public:
+  // Map the file. Throws on failure.
+  void open(std::string const& path);
+
+  // Returns the number of slices (throws if the file ends with a partial slice).
+  std::size_t length() const;
+  std::size_t byteSize() const { return _file ? _file->size() : 0; }
+
+  // Return slice i (throws if out of range).
+  VPackSlice slice(std::size_t i) const;
+
+  // The mapping, to be kept alive by anything that references its memory.
+  std::shared_ptr<MappedFile> const& file() const { return _file; }
+
+private:
+  // Extends the index up to the end of slice i (or the end of the file).
+  void indexUntil(std::size_t i) const;
+  std::size_t sliceSize(std::size_t pos) const;
+
+  std::shared_ptr<MappedFile> _file;
+  std::string _path;
+  // start of slice i, followed by the end of the last indexed slice
+  mutable std::vector<std::size_t> _offsets;
+  // the index covers the entire file
+  mutable bool _complete = false;
+};
+
+// NVPackFile is a node wrapper around VPackFile.
+class NVPackFile : public ObjectWrap<NVPackFile, VPackFile, std::unique_ptr<VPackFile>> {
+  NVPackFile(): ObjectWrap() {}
+
+public:
+  static NAN_MODULE_INIT(Init) {
+    auto tpl = Nan::New<v8::FunctionTemplate>(New);
+    tpl->SetClassName(Nan::New("VPackFile").ToLocalChecked());
+    tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+    Nan::SetPrototypeMethod(tpl, "slice", NVPackFile::slice);
+    Nan::SetPrototypeMethod(tpl, "decode", NVPackFile::decode);
+    Nan::SetPrototypeMethod(tpl, "addToRequest", NVPackFile::addToRequest);
+
+    auto itpl = tpl->InstanceTemplate();
+    Nan::SetAccessor(itpl, toString("length"), NVPackFile::getLength);
+    Nan::SetAccessor(itpl, toString("byteSize"), NVPackFile::getByteSize);
+
+    initClass("VPackFile", target, tpl);
+  }
+
+  // Node constructor, takes the path of the file.
+  static NAN_METHOD(New);
+  // Return slice i as a Buffer that references the mapped file (no copy).
+  static NAN_METHOD(slice);
+  // Decode slice i, optionally projected ({paths}) as in vpackDecode.
+  static NAN_METHOD(decode);
+  // Add slice i as velocypack body to a Request.
+  static NAN_METHOD(addToRequest);
+
+  // Returns the number of slices in the file.
+  static NAN_GETTER(getLength);
+  // Returns the size of the file.
+  static NAN_GETTER(getByteSize);
+};
+
+}}}
+#endif
@@ -40,6 +40,10 @@ public:
     return _cppClass.get();
   }
 
+  TPtr const& cppPtr() const {
+    return _cppClass;
+  }
+
   // NewInstance creates a new instance of the object.
   static Nan::MaybeLocal<v8::Object> NewInstance() {
     auto ctor = Nan::New(constructor());
@@ -56,7 +60,8 @@ public:
     // wrapped objects
     
     // Basic checks done as asserts by UnWrap()
-    if (!handle.IsEmpty() && handle->InternalFieldCount() == 1) {
+    // (subclasses may reserve internal fields after the wrapper)
+    if (!handle.IsEmpty() && handle->InternalFieldCount() >= 1) {
       // Check the prototype.  This effectively stops inheritance,
       // but since this is created from a factory function and no
       // constructor is exposed that should not be ok.  If you really need
@@ -72,6 +77,17 @@ public:
     return nullptr;
   }
 
+  // HasInstance returns true if the given value is one of our own
+  // wrapped objects (same checks as CheckedUnwrap, without throwing).
+  static bool HasInstance(v8::Local<v8::Value> value) {
+    if (value.IsEmpty() || !value->IsObject()) {
+      return false;
+    }
+    auto handle = value->ToObject();
+    return handle->InternalFieldCount() >= 1 &&
+           handle->GetPrototype() == prototype();
+  }
+
 protected:
   void setCppClass(TPtr x) {
     _cppClass = std::move(x);
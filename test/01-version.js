@@ -1,6 +1,8 @@
 import {describe, it, before, after, beforeEach} from 'mocha'
 import {expect} from 'chai'
 import fuerte from '..';
+import fs from 'fs';
+import os from 'os';
 import {serverURL} from './util.js';
 
 describe('Getting the server version', () => {
@@ -14,5 +16,216 @@ describe('Getting the server version', () => {
           done();
         }).catch(done);
     })
+    it('references its request', (done) => {
+      conn.get('/_api/version')
+        .then((res) => {
+          expect(res.request.path).to.equal('/_api/version');
+          const contentType = res.getHeader('Content-Type');
+          if (contentType !== undefined) {
+            expect(res.getHeader('content-type')).to.equal(contentType);
+          }
+          expect(res.getHeader('x-no-such-header')).to.be.undefined;
+          expect(res.body).to.equal(res.body);
+          done();
+        }).catch(done);
+    })
+    it('can be released', (done) => {
+      conn.get('/_api/version')
+        .then((res) => {
+          const body = res.body;
+          res.release();
+          expect(res.body).to.equal(body);
+          expect(() => res.payload).to.throw();
+          done();
+        }).catch(done);
+    })
+    it('can be parsed on the IO thread', (done) => {
+      conn.get({ path: '/_api/version', parseJson: true, acceptType: 'application/json' })
+        .then((res) => {
+          expect(res.body).to.haveOwnProperty('version');
+          done();
+        }).catch(done);
+    })
+    it('can be rendered as JSON', (done) => {
+      conn.get({ path: '/_api/version', renderJson: true })
+        .then((res) => {
+          const json = JSON.parse(res.jsonBuffer().toString());
+          expect(json).to.deep.equal(res.body);
+          done();
+        }).catch(done);
+    })
+  })
+  describe('resolving collection names', () => {
+    const conn = new fuerte.connect({ host: serverURL, resolveCollectionNames: true });
+    const collection = `testnames_${Date.now()}`;
+    before(async () => {
+      await conn.post('/_api/collection', { name: collection });
+      await conn.post(`/_api/document/${collection}`, { _key: 'doc' });
+    })
+    after(async () => {
+      await conn.delete(`/_api/collection/${collection}`);
+    })
+    it('decodes _id with the collection name', (done) => {
+      conn.get({ path: `/_api/document/${collection}/doc`, acceptType: 'application/x-velocypack' })
+        .then((res) => {
+          expect(res.body._id).to.equal(`${collection}/doc`);
+          expect(res.body._key).to.equal('doc');
+          done();
+        }).catch(done);
+    })
+    it('answers requests that wait for the same refresh', (done) => {
+      // a new connection starts with an empty cache
+      const fresh = new fuerte.connect({ host: serverURL, resolveCollectionNames: true });
+      const path = `/_api/document/${collection}/doc`;
+      Promise.all([1, 2, 3].map(() => fresh.get({ path: path, acceptType: 'application/x-velocypack' })))
+        .then((responses) => {
+          responses.forEach((res) => expect(res.body._id).to.equal(`${collection}/doc`));
+          done();
+        }).catch(done);
+    })
+  })
+  describe('without retaining requests', () => {
+    const conn = new fuerte.connect({ host: serverURL, retainRequest: false });
+    it('has no request', (done) => {
+      conn.get('/_api/version')
+        .then((res) => {
+          expect(res.request).to.be.undefined;
+          expect(res.body).to.haveOwnProperty('server');
+          done();
+        }).catch(done);
+    })
+  })
+  describe('with spilled responses', () => {
+    const conn = new fuerte.connect({ host: serverURL, spillThreshold: 1 });
+    it('reads the body from the temp file', (done) => {
+      conn.get('/_api/version')
+        .then((res) => {
+          expect(res.body).to.haveOwnProperty('server');
+          expect(res.payload.length).to.be.above(1);
+          done();
+        }).catch(done);
+    })
+    it('reads velocypack from the temp file', (done) => {
+      conn.get({ path: '/_api/version', acceptType: 'application/x-velocypack' })
+        .then((res) => {
+          expect(res.body).to.haveOwnProperty('server');
+          expect(res.slices.length).to.equal(1);
+          expect(fuerte.vpackDecode(res.slices[0])).to.deep.equal(res.body);
+          expect(res.payload.equals(Buffer.concat(res.slices))).to.be.true;
+          done();
+        }).catch(done);
+    })
+  })
+  describe('with hedged requests', () => {
+    const conn = new fuerte.connect({ host: serverURL, poolSize: 2, hedgePercentile: 50 });
+    before(async () => {
+      // collect enough response times for the route to be hedged
+      for (let i = 0; i < 20; i++) {
+        await conn.get('/_api/version');
+      }
+    })
+    it('answers every request once', (done) => {
+      const calls = new Array(50).fill(0);
+      let answered = 0;
+      calls.forEach((_, i) => {
+        conn.get('/_api/version', (err, res) => {
+          if (err) {
+            return done(err);
+          }
+          expect(res.body).to.haveOwnProperty('server');
+          if (calls[i]++ === 0 && ++answered === calls.length) {
+            // give late (hedged) responses the chance to show up
+            setTimeout(() => {
+              calls.forEach((n) => expect(n).to.equal(1));
+              done();
+            }, 500);
+          }
+        });
+      });
+    })
+  })
+  describe('with hedged requests and a single connection', () => {
+    const conn = new fuerte.connect({ host: serverURL, poolSize: 1, hedgePercentile: 50 });
+    before(async () => {
+      for (let i = 0; i < 20; i++) {
+        await conn.get('/_api/version');
+      }
+    })
+    it('does not hedge on the same connection', async () => {
+      const results = await Promise.all(new Array(20).fill(0).map(() => conn.get('/_api/version')));
+      results.forEach((res) => expect(res.body).to.haveOwnProperty('server'));
+      expect(conn).to.have.a.property('poolSize', 1);
+      expect(conn).to.have.a.property('requestsLeft', 0);
+    })
+  })
+})
+
+describe('Sending a JSON text body', () => {
+  const conn = new fuerte.connect(serverURL);
+  it('sends the json option as body', (done) => {
+    conn.post({ path: '/_api/cursor', json: '{"query":"RETURN @a + 1","bindVars":{"a":41}}' })
+      .then((res) => {
+        expect(res.body.result).to.deep.equal([42]);
+        done();
+      }).catch(done);
+  })
+  it('sends a Buffer added with addJsonBody', (done) => {
+    const req = new fuerte.Request();
+    req.path = '/_api/cursor';
+    req.method = 'post';
+    expect(req.addJsonBody(Buffer.from('{"query":"RETURN [1, \\"two\\"]"}'))).to.equal(req);
+    conn.sendRequest(req)
+      .then((res) => {
+        expect(res.body.result).to.deep.equal([[1, "two"]]);
+        done();
+      }).catch(done);
+  })
+  it('reports malformed JSON to the callback', (done) => {
+    conn.post({ path: '/_api/cursor', json: '{"query":' }, (err, res) => {
+      expect(err).to.be.an.instanceof(Error);
+      expect(err.message).to.contain('invalid JSON');
+      expect(res).to.be.undefined;
+      done();
+    });
+  })
+})
+
+describe('Sending a file body', () => {
+  const conn = new fuerte.connect(serverURL);
+  const path = `${os.tmpdir()}/fuerte_body_${Date.now()}.json`;
+  const content = '{"name":"fuerte","size":42}';
+  before(() => fs.writeFileSync(path, `xx${content}yy`));
+  after(() => fs.unlinkSync(path));
+  it('sends the file content', (done) => {
+    const req = new fuerte.Request();
+    req.path = '/_admin/echo';
+    req.method = 'post';
+    req.contentType = 'application/json';
+    req.addFile(path, 2, content.length);
+    conn.sendRequest(req)
+      .then((res) => {
+        expect(res.body.requestBody).to.equal(content);
+        done();
+      }).catch(done);
+  })
+  it('rejects bodies above the maximum size', (done) => {
+    const large = `${path}.large`;
+    // a sparse file, nothing is read before the size is checked
+    fs.writeFileSync(large, '');
+    fs.truncateSync(large, 1024 * 1024 * 1024 + 1);
+    conn.post({ path: '/_admin/echo', file: large })
+      .then(() => { throw new Error('expected an error'); }, (err) => {
+        expect(err.message).to.contain('exceeds the maximum');
+      })
+      .then(() => { fs.unlinkSync(large); done(); },
+            (err) => { fs.unlinkSync(large); done(err); });
+  })
+  it('rejects files that are not regular', (done) => {
+    conn.post({ path: '/_admin/echo', file: '/dev/null' })
+      .then(() => done(new Error('expected an error')))
+      .catch((err) => {
+        expect(err).to.be.an.instanceof(Error);
+        done();
+      });
   })
 })
@@ -0,0 +1,217 @@
+import {describe, it, before, after, beforeEach} from 'mocha'
+import {expect} from 'chai'
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import fuerte from '..';
+
+describe('Decoding velocypack with a projection', () => {
+  const docs = [
+    { _key: "1", a: { b: 1, c: 2 }, c: "x", d: true },
+    { _key: "2", a: { c: 3 }, d: false },
+  ];
+  const buffer = fuerte.vpackEncode(docs);
+  it('materializes only the given paths', () => {
+    const result = fuerte.vpackDecode(buffer, { paths: ["_key", "a.b", "c"] });
+    expect(result).to.deep.equal([
+      { _key: "1", a: { b: 1 }, c: "x" },
+      { _key: "2", a: {} },
+    ]);
+  })
+  it('accepts a compiled projection', () => {
+    const projection = new fuerte.Projection(["a"]);
+    const result = fuerte.vpackDecode(buffer, { paths: projection });
+    expect(result).to.deep.equal([
+      { a: { b: 1, c: 2 } },
+      { a: { c: 3 } },
+    ]);
+  })
+})
+
+describe('Decoding velocypack into columns', () => {
+  const rows = [
+    { ts: 1.5, value: 10, sensor: "a" },
+    { ts: 2.5, sensor: "b" },
+    { ts: 3.5, value: 30 },
+  ];
+  const buffer = fuerte.vpackEncode(rows);
+  it('fills typed arrays', () => {
+    const result = fuerte.vpackDecodeColumns(buffer, { ts: 'float64', value: 'int32', sensor: 'string' });
+    expect(result.ts).to.be.an.instanceof(Float64Array);
+    expect(Array.from(result.ts)).to.deep.equal([1.5, 2.5, 3.5]);
+    expect(result.value).to.be.an.instanceof(Int32Array);
+    expect(Array.from(result.value)).to.deep.equal([10, 0, 30]);
+    expect(result.sensor).to.deep.equal(["a", "b", null]);
+  })
+  it('reads cursor results', () => {
+    const cursor = fuerte.vpackEncode({ result: rows, hasMore: false });
+    const result = fuerte.vpackDecodeColumns(cursor, { value: 'float64' });
+    expect(result.value[0]).to.equal(10);
+    expect(result.value[1]).to.be.NaN;
+  })
+})
+
+describe('Building velocypack incrementally', () => {
+  it('produces the same slice as vpackEncode', () => {
+    const builder = new fuerte.Builder();
+    builder.openObject();
+    builder.add("name", "Jan");
+    builder.openArray("values");
+    builder.addValue(1).addValue({ a: [2, 3] });
+    builder.close();
+    builder.close();
+    expect(builder.isClosed).to.be.true;
+    const buffer = builder.toBuffer();
+    expect(buffer.length).to.equal(builder.byteSize);
+    expect(fuerte.vpackDecode(buffer)).to.deep.equal({ name: "Jan", values: [1, { a: [2, 3] }] });
+  })
+  it('adds object members with add and array values with addValue', () => {
+    const builder = new fuerte.Builder();
+    expect(() => builder.add(1)).to.throw(TypeError);
+    builder.openArray();
+    expect(() => builder.addValue("a", 1)).to.throw(TypeError);
+    builder.addValue(1).close();
+    expect(fuerte.vpackDecode(builder.toBuffer())).to.deep.equal([1]);
+  })
+  it('can be added to a request', () => {
+    const builder = new fuerte.Builder();
+    builder.openArray().addValue(1).close();
+    const req = new fuerte.Request();
+    expect(req.addBody(builder)).to.equal(req);
+  })
+})
+
+describe('Translating system attributes', () => {
+  const doc = { _key: "abc", _rev: "1", _from: "a/1", _to: "b/2", name: "Jan" };
+  after(() => {
+    fuerte.vpackTranslateAttributes(false);
+  })
+  it('produces smaller slices that decode to the same value', () => {
+    const plain = fuerte.vpackEncode(doc);
+    expect(fuerte.vpackTranslateAttributes(true)).to.be.false;
+    const translated = fuerte.vpackEncode(doc);
+    expect(translated.length).to.be.below(plain.length);
+    expect(fuerte.vpackDecode(translated)).to.deep.equal(doc);
+    expect(fuerte.vpackTranslateAttributes(false)).to.be.true;
+    expect(fuerte.vpackDecode(translated)).to.deep.equal(doc);
+  })
+  it('decodes translated keys in projections and columns', () => {
+    fuerte.vpackTranslateAttributes(true);
+    const translated = fuerte.vpackEncode([doc]);
+    fuerte.vpackTranslateAttributes(false);
+    expect(fuerte.vpackDecode(translated, { paths: ['_key', 'name'] })).to.deep.equal([{ _key: "abc", name: "Jan" }]);
+    expect(fuerte.vpackDecodeColumns(translated, { _from: 'string' })._from).to.deep.equal(["a/1"]);
+  })
+})
+
+describe('Reusing encoder buffers', () => {
+  it('takes buffers from the pool in steady state', () => {
+    fuerte.vpackEncode({ warmup: true });
+    const before = fuerte.vpackPoolStats();
+    for (let i = 0; i < 10; i++) {
+      fuerte.vpackEncode({ i: i, name: "doc" });
+    }
+    const after = fuerte.vpackPoolStats();
+    expect(after.hits - before.hits).to.equal(10);
+    expect(after.misses).to.equal(before.misses);
+    expect(after.retainedBuffers).to.be.above(0);
+  })
+})
+
+describe('Encoding & decoding many values at once', () => {
+  const values = [{ a: 1 }, [1, 2, 3], "text", { b: { c: null } }];
+  it('round trips through one buffer', () => {
+    const { buffer, offsets } = fuerte.vpackEncodeMany(values);
+    expect(offsets).to.be.an.instanceof(Uint32Array);
+    expect(offsets.length).to.equal(values.length + 1);
+    expect(offsets[values.length]).to.equal(buffer.length);
+    expect(fuerte.vpackDecodeMany(buffer)).to.deep.equal(values);
+  })
+  it('decodes a list of buffers', () => {
+    const buffers = values.map((v) => fuerte.vpackEncode([v]));
+    expect(fuerte.vpackDecodeMany(buffers)).to.deep.equal(values.map((v) => [v]));
+  })
+})
+
+describe('Memoizing frozen values', () => {
+  it('encodes memoized values like plain values', () => {
+    const bindVars = { status: "active", tags: ["a", "b"] };
+    const plain = fuerte.vpackEncode({ bindVars: bindVars });
+    expect(fuerte.freeze(bindVars)).to.equal(bindVars);
+    expect(Object.isFrozen(bindVars.tags)).to.be.true;
+    expect(fuerte.vpackEncode({ bindVars: bindVars }).equals(plain)).to.be.true;
+    expect(fuerte.vpackForget(bindVars)).to.be.true;
+    expect(fuerte.vpackForget(bindVars)).to.be.false;
+  })
+  it('can be memoized again after vpackForget', () => {
+    const value = fuerte.freeze({ a: [1, 2] });
+    const plain = fuerte.vpackEncode(value);
+    expect(fuerte.vpackForget(value)).to.be.true;
+    expect(fuerte.vpackMemoize(value)).to.equal(value);
+    expect(fuerte.vpackEncode(value).equals(plain)).to.be.true;
+    expect(Object.getOwnPropertyNames(value)).to.deep.equal(['a']);
+    expect(fuerte.vpackForget(value)).to.be.true;
+  })
+  it('rejects values that are not frozen', () => {
+    expect(() => fuerte.vpackMemoize({ a: 1 })).to.throw(TypeError);
+    expect(() => fuerte.vpackMemoize(Object.freeze({ a: { b: 1 } }))).to.throw(TypeError);
+  })
+  it('follows the attribute translation', () => {
+    const doc = fuerte.freeze({ _key: "abc", name: "Jan" });
+    fuerte.vpackTranslateAttributes(true);
+    const translated = fuerte.vpackEncode([{ _key: "abc", name: "Jan" }]);
+    expect(fuerte.vpackEncode([doc]).equals(translated)).to.be.true;
+    fuerte.vpackTranslateAttributes(false);
+    const plain = fuerte.vpackEncode([{ _key: "abc", name: "Jan" }]);
+    expect(fuerte.vpackEncode([doc]).equals(plain)).to.be.true;
+    fuerte.vpackForget(doc);
+  })
+})
+
+describe('Reading velocypack files', () => {
+  const values = [{ a: 1 }, [1, 2, 3], { b: { c: "text" } }];
+  const fileName = path.join(os.tmpdir(), `fuerte-test-${process.pid}.vpack`);
+  before(() => {
+    fs.writeFileSync(fileName, fuerte.vpackEncodeMany(values).buffer);
+  })
+  after(() => {
+    fs.unlinkSync(fileName);
+  })
+  it('indexes and decodes slices', () => {
+    const file = new fuerte.VPackFile(fileName);
+    expect(file.length).to.equal(values.length);
+    expect(file.decode(2)).to.deep.equal(values[2]);
+    expect(file.decode(2, { paths: ["b.c"] })).to.deep.equal(values[2]);
+    expect(fuerte.vpackDecode(file.slice(1))).to.deep.equal(values[1]);
+    expect(() => file.decode(3)).to.throw();
+  })
+  it('adds slices to requests', () => {
+    const file = new fuerte.VPackFile(fileName);
+    const req = new fuerte.Request();
+    expect(file.addToRequest(req, 0)).to.equal(req);
+  })
+  it('rejects a slice header that is cut off', () => {
+    const truncatedName = `${fileName}.truncated`;
+    // 0xbf starts a long string, its 8 byte length is missing
+    fs.writeFileSync(truncatedName, Buffer.concat([fuerte.vpackEncode(values[0]), Buffer.from([0xbf])]));
+    try {
+      const file = new fuerte.VPackFile(truncatedName);
+      expect(file.decode(0)).to.deep.equal(values[0]);
+      expect(() => file.length).to.throw(/truncated/);
+    } finally {
+      fs.unlinkSync(truncatedName);
+    }
+  })
+  it('rejects a slice with a corrupt nested header', () => {
+    const corruptName = `${fileName}.corrupt`;
+    // array of 4 bytes whose string member claims 5 bytes of content
+    fs.writeFileSync(corruptName, Buffer.from([0x02, 0x04, 0x45, 0x61]));
+    try {
+      const file = new fuerte.VPackFile(corruptName);
+      expect(() => file.decode(0)).to.throw(/invalid slice/);
+      expect(() => file.slice(0)).to.throw(/invalid slice/);
+    } finally {
+      fs.unlinkSync(corruptName);
+    }
+  })
+})
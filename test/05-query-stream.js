@@ -0,0 +1,41 @@
+import {describe, it, before, after, beforeEach} from 'mocha'
+import {expect} from 'chai'
+import fuerte from '..';
+import {serverURL} from './util.js';
+
+describe('Streaming a query result', () => {
+  const conn = new fuerte.connect(serverURL);
+  it('delivers all batches', (done) => {
+    let count = 0;
+    conn.queryStream({ query: 'FOR i IN 1..25 RETURN { i: i, sq: i * i }', batchSize: 10, paths: ['i'] })
+      .on('data', (docs) => {
+        expect(docs.length).to.be.at.most(10);
+        docs.forEach((doc) => {
+          expect(doc).to.deep.equal({ i: ++count });
+        });
+      })
+      .on('error', done)
+      .on('end', () => {
+        expect(count).to.equal(25);
+        done();
+      });
+  })
+  it('stops when destroyed during the first request', (done) => {
+    const stream = conn.queryStream({ query: 'FOR i IN 1..25 RETURN i', batchSize: 10 });
+    stream.on('data', () => done(new Error('unexpected data')));
+    stream.on('close', () => {
+      // give the pending request time to settle
+      setTimeout(done, 200);
+    });
+    stream.read(0);
+    stream.destroy();
+  })
+  it('reports query errors', (done) => {
+    conn.queryStream('FOR i IN no_such_collection RETURN i')
+      .on('data', () => done(new Error('unexpected data')))
+      .on('error', (err) => {
+        expect(err).to.be.an.instanceof(Error);
+        done();
+      });
+  })
+})